@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireScheduler.h"
+
+// Shots owed after a long hitch are dropped past this, instead of firing a burst
+static constexpr int32 MaxShotsPerAdvance = 16;
+
+FFireScheduler::FFireScheduler(float InFiringRate)
+	: FiringRate(FMath::Max(InFiringRate, KINDA_SMALL_NUMBER)), NextShotTime(0.0), bTriggerHeld(false)
+{
+}
+
+void FFireScheduler::SetFiringRate(float InFiringRate)
+{
+	FiringRate = FMath::Max(InFiringRate, KINDA_SMALL_NUMBER);
+}
+
+bool FFireScheduler::PressTrigger(double Time)
+{
+	bTriggerHeld = true;
+
+	// Still cooling down from the last shot, Advance fires once the cooldown is over
+	if (Time < NextShotTime)
+		return false;
+
+	NextShotTime = Time + FiringRate;
+	return true;
+}
+
+void FFireScheduler::ReleaseTrigger()
+{
+	bTriggerHeld = false;
+}
+
+int32 FFireScheduler::Advance(double Time, TArray<double>& OutShotTimes)
+{
+	if (!bTriggerHeld)
+		return 0;
+
+	int32 NumShots = 0;
+	while (NextShotTime <= Time && NumShots < MaxShotsPerAdvance)
+	{
+		OutShotTimes.Add(NextShotTime);
+		NextShotTime += FiringRate;
+		NumShots++;
+	}
+
+	// Resynchronize instead of carrying the backlog into the next frames
+	if (NextShotTime <= Time)
+		NextShotTime = Time + FiringRate;
+
+	return NumShots;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Automatic fire clock. Keeps the time of the next owed shot while the trigger is held
+ * and reports every shot due by a given time, so the fire rate doesn't depend on frame rate
+ */
+class SHOOTER_API FFireScheduler
+{
+public:
+	explicit FFireScheduler(float InFiringRate = 0.1f);
+
+	void SetFiringRate(float InFiringRate);
+
+	// Trigger pressed at Time. Returns true when a shot is due right away
+	bool PressTrigger(double Time);
+
+	void ReleaseTrigger();
+
+	// Appends the time of every shot owed up to Time and returns how many were added
+	int32 Advance(double Time, TArray<double>& OutShotTimes);
+
+	FORCEINLINE bool IsTriggerHeld() const { return bTriggerHeld; }
+	FORCEINLINE float GetFiringRate() const { return FiringRate; }
+
+private:
+	// Seconds between two shots
+	float FiringRate;
+
+	// Earliest time the next shot can happen
+	double NextShotTime;
+
+	bool bTriggerHeld;
+};
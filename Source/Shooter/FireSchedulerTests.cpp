@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "FireScheduler.h"
+
+namespace
+{
+	// Seconds of held trigger per frame rate
+	constexpr double FireSchedulerTestSeconds = 60.0;
+
+	// Presses the trigger at 0 and holds it, advancing once per frame. Returns the shots fired
+	int32 HoldTrigger(FFireScheduler& Scheduler, int32 FrameRate, TArray<double>& OutShotTimes)
+	{
+		OutShotTimes.Reset();
+		if (Scheduler.PressTrigger(0.0))
+			OutShotTimes.Add(0.0);
+
+		// Frame times from the frame index so the clock itself doesn't drift
+		const int32 NumFrames = FMath::RoundToInt(FireSchedulerTestSeconds * FrameRate);
+		for (int32 Frame = 1; Frame <= NumFrames; Frame++)
+			Scheduler.Advance(static_cast<double>(Frame) / FrameRate, OutShotTimes);
+
+		Scheduler.ReleaseTrigger();
+		return OutShotTimes.Num();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireSchedulerFrameRateTest, "Shooter.FireScheduler.FrameRateIndependence", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FFireSchedulerFrameRateTest::RunTest(const FString& Parameters)
+{
+	const int32 FrameRates[] = { 20, 30, 60, 144 };
+	const float FiringRates[] = { 0.1f, 0.075f, 0.13f };
+
+	TArray<double> ShotTimes;
+	for (const float FiringRate : FiringRates)
+	{
+		const double NominalShots = FireSchedulerTestSeconds / FiringRate;
+		for (const int32 FrameRate : FrameRates)
+		{
+			FFireScheduler Scheduler(FiringRate);
+			const int32 NumShots = HoldTrigger(Scheduler, FrameRate, ShotTimes);
+			AddInfo(FString::Printf(TEXT("%.3f s between shots at %d Hz: %d shots in %.0f s, nominal %.1f"),
+				FiringRate, FrameRate, NumShots, FireSchedulerTestSeconds, NominalShots));
+
+			const FString Context = FString::Printf(TEXT("%.3f s between shots at %d Hz"), FiringRate, FrameRate);
+			TestTrue(FString::Printf(TEXT("%s fires within one shot per minute of the nominal rate"), *Context),
+				FMath::Abs(NumShots - NominalShots) <= 1.0 + KINDA_SMALL_NUMBER);
+
+			// Shots between frames keep their own time, they are not bunched onto the frame
+			int32 NumUneven = 0;
+			for (int32 Shot = 1; Shot < ShotTimes.Num(); Shot++)
+			{
+				if (!FMath::IsNearlyEqual(ShotTimes[Shot] - ShotTimes[Shot - 1], static_cast<double>(FiringRate), 1e-4))
+					NumUneven++;
+			}
+			TestEqual(FString::Printf(TEXT("%s spaces shots evenly"), *Context), NumUneven, 0);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireSchedulerCooldownTest, "Shooter.FireScheduler.Cooldown", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FFireSchedulerCooldownTest::RunTest(const FString& Parameters)
+{
+	FFireScheduler Scheduler(0.1f);
+	TArray<double> ShotTimes;
+
+	TestTrue(TEXT("The first press fires right away"), Scheduler.PressTrigger(0.0));
+	Scheduler.ReleaseTrigger();
+
+	// Tapping faster than the fire rate doesn't fire faster
+	TestFalse(TEXT("A press during the cooldown waits"), Scheduler.PressTrigger(0.05));
+	TestEqual(TEXT("The waiting shot is not due before the cooldown ends"), Scheduler.Advance(0.09, ShotTimes), 0);
+	TestEqual(TEXT("The waiting shot fires when the cooldown ends"), Scheduler.Advance(0.1, ShotTimes), 1);
+
+	// A hitch drops the backlog instead of firing it all at once
+	ShotTimes.Reset();
+	Scheduler.Advance(10.0, ShotTimes);
+	TestTrue(TEXT("A hitch fires a bounded burst"), ShotTimes.Num() <= 16);
+	TestEqual(TEXT("The clock resumes after the hitch"), Scheduler.Advance(10.2, ShotTimes), 1);
+	return true;
+}
+
+#endif
@@ -1,35 +1,60 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Item.h"
+#include "Shooter.h"
 #include "Components/BoxComponent.h"
 #include "Components/SphereComponent.h"
-#include "Components/WidgetComponent.h"
 #include "Camera/CameraComponent.h"
 #include "ShooterCharacter.h"
+#include "ItemInterpSubsystem.h"
+#include "ItemProximitySubsystem.h"
+#include "Engine/CollisionProfile.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+static TAutoConsoleVariable<int32> CVarItemDormancy(
+	TEXT("Shooter.Net.ItemDormancy"),
+	1,
+	TEXT("0: items stay awake for the net driver, the baseline for the benchmark's NetBroadcastMs\n")
+	TEXT("1: items lying on the ground or parked in the pool go dormant"));
+
+DECLARE_CYCLE_STAT(TEXT("SetItemProperties"), STAT_SetItemProperties, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Collision Profile Changes"), STAT_ItemCollisionProfileChanges, STATGROUP_Shooter);
 
 // Sets default values
 AItem::AItem()
-	: ItemName(FString("Default")), ItemCount(0), ItemRarity(EItemRarity::EIR_Common), ItemState(EItemState::EIS_Pickup),
+	: ItemDefinition(nullptr), ItemCount(0), ItemState(EItemState::EIS_Pickup),
 	// Item interpolation variables
-	ZCurveTime(0.7f), ItemInterpStartLocation(FVector(0.0f)), CameraTargetLocation(FVector(0.0f)), bInterping(false),
-	InterpInitialYawOffset(0.0f)
+	ItemInterpStartLocation(FVector(0.0f)), CameraTargetLocation(FVector(0.0f)), bInterping(false), bParkedInPool(false)
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Items don't tick, interpolation is driven by UItemInterpSubsystem
+	PrimaryActorTick.bCanEverTick = false;
 
 	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ItemMesh"));
 	SetRootComponent(ItemMesh);
 
 	CollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionBox"));
 	CollisionBox->SetupAttachment(ItemMesh);
-	CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
+	CollisionBox->SetCollisionProfileName(FName("ItemTrace"));
 	
 	AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
 	AreaSphere->SetupAttachment(GetRootComponent());
-
-	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
-	PickupWidget->SetupAttachment(GetRootComponent());
+	AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	AreaSphere->SetGenerateOverlapEvents(false);
+
+	// Loot on the ground never changes, keep it out of the net driver's per tick work until it does
+	bReplicates = true;
+	NetDormancy = DORM_DormantAll;
+	NetCullDistanceSquared = FMath::Square(10000.0f);
+
+#if WITH_EDITORONLY_DATA
+	// The old defaults, anything else was set by a blueprint or a placed item
+	ItemName_DEPRECATED = FString("Default");
+	ItemRarity_DEPRECATED = EItemRarity::EIR_Common;
+	ItemZCurve_DEPRECATED = nullptr;
+	ZCurveTime_DEPRECATED = 0.7f;
+	ItemScaleCurve_DEPRECATED = nullptr;
+#endif
 }
 
 // Called when the game starts or when spawned
@@ -37,161 +62,101 @@ void AItem::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Hide Pickup widget
-	if (PickupWidget)
-		PickupWidget->SetVisibility(false);
-	
-	// Sets ItemStars array based on ItemRarity
-	SetActiveStars();
-
-	// Setup Overlap for Area Sphere
-	AreaSphere->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnSphereOverlap);
-	AreaSphere->OnComponentEndOverlap.AddDynamic(this, &AItem::OnSphereEndOverlap); 
-
 	// Set item properties based on state
 	SetItemProperties(ItemState);
+	UpdateProximityRegistration();
+	UpdateNetDormancy();
 }
 
-// Called every frame
-void AItem::Tick(float DeltaTime)
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UItemProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UItemProximitySubsystem>())
+		ProximitySubsystem->UnregisterItem(this);
 
-	// Handle item interping when in the EquipInterping state
-	ItemInterp(DeltaTime);
+	Super::EndPlay(EndPlayReason);
 }
 
-void AItem::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void AItem::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
-	if (OtherActor)
-	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
-			ShooterCharacter->UpdateTheOverlappedItemCount(1);
-	}
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only sent when marked dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AItem, ItemDefinition, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AItem, ItemCount, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AItem, ItemState, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AItem, RestingMovement, Params);
 }
 
-void AItem::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AItem::OnRep_ItemState()
 {
-	if (OtherActor)
-	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
-			ShooterCharacter->UpdateTheOverlappedItemCount(-1);
-	}
+	SetItemProperties(ItemState);
+	UpdateProximityRegistration();
 }
 
-void AItem::SetActiveStars()
+void AItem::OnRep_RestingMovement()
 {
-	for (uint32_t i = 0; i < 5; i++)
-		ItemStars.Add(false);
-
-	switch (ItemRarity)
-	{
-	case EItemRarity::EIR_Damaged:
-		ItemStars[0] = true;
-		break;
-	case EItemRarity::EIR_Common:
-		ItemStars[0] = true;
-		ItemStars[1] = true;
-		break;
-	case EItemRarity::EIR_Uncommon:
-		ItemStars[0] = true;
-		ItemStars[1] = true;
-		ItemStars[2] = true;
-		break;
-	case EItemRarity::EIR_Rare:
-		ItemStars[0] = true;
-		ItemStars[1] = true;
-		ItemStars[2] = true;
-		ItemStars[3] = true;
-		break;
-	case EItemRarity::EIR_Legendary:
-		ItemStars[0] = true;
-		ItemStars[1] = true;
-		ItemStars[2] = true;
-		ItemStars[3] = true;
-		ItemStars[4] = true;
-		break;
-	}
+	// Late joiners receive the last resting place of items which have been picked up since
+	if (ItemState == EItemState::EIS_Pickup)
+		SetActorLocationAndRotation(RestingMovement.Location, RestingMovement.Rotation, false, nullptr, ETeleportType::ResetPhysics);
 }
 
 void AItem::SetItemProperties(EItemState State)
 {
-	switch (State)
-	{
-	case EItemState::EIS_Pickup:
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);	
-
-		// Set area sphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly); 
-
-		// Set collision box properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-		break;
-	case EItemState::EIS_Equipped:
-		PickupWidget->SetVisibility(false);
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		// Set area sphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		// Set collision box properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		break;
-	case EItemState::EIS_PickedUp:
-		break;
-	case EItemState::EIS_EquipInterping:
-		PickupWidget->SetVisibility(false);
-		// Set mesh properties 
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_SetItemProperties);
+
+	const FItemStateProfile& Profile = GetItemStateProfile(State);
+	if (!Profile.bApply)
+		return;
+
+	// Stop simulating before the mesh loses its physics collision
+	if (!Profile.bSimulatePhysics && ItemMesh->IsSimulatingPhysics())
 		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		// Set area sphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		// Set collision box properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		break;
-	case EItemState::EIS_Falling:
-		// Set mesh properties
+
+	ApplyCollisionProfile(ItemMesh, Profile.MeshProfile);
+	ApplyCollisionProfile(CollisionBox, Profile.BoxProfile);
+
+	if (ItemMesh->IsGravityEnabled() != Profile.bSimulatePhysics)
+		ItemMesh->SetEnableGravity(Profile.bSimulatePhysics);
+
+	// Start simulating once the falling profile is in place
+	if (Profile.bSimulatePhysics && !ItemMesh->IsSimulatingPhysics())
 		ItemMesh->SetSimulatePhysics(true);
-		ItemMesh->SetEnableGravity(true);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldStatic, ECollisionResponse::ECR_Block);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-
-		// Set area sphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		// Set collision box properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		break;
-	}
+
+	ItemMesh->SetVisibility(true);
+}
+
+const FItemStateProfile& AItem::GetItemStateProfile(EItemState State)
+{
+	// Indexed by EItemState
+	static const FItemStateProfile Profiles[] =
+	{
+		// EIS_Pickup: only the collision box answers the item trace
+		{ true, UCollisionProfile::NoCollision_ProfileName, FName("ItemTrace"), false },
+		// EIS_Equipped
+		{ true, UCollisionProfile::NoCollision_ProfileName, UCollisionProfile::NoCollision_ProfileName, false },
+		// EIS_PickedUp: components are left as they are
+		{ false, NAME_None, NAME_None, false },
+		// EIS_EquipInterping
+		{ true, UCollisionProfile::NoCollision_ProfileName, UCollisionProfile::NoCollision_ProfileName, false },
+		// EIS_Falling: the mesh simulates and lands on static geometry
+		{ true, FName("ItemFalling"), UCollisionProfile::NoCollision_ProfileName, true },
+	};
+	static_assert(UE_ARRAY_COUNT(Profiles) == static_cast<int32>(EItemState::EIR_MAX), "Every item state needs a profile");
+
+	return Profiles[static_cast<int32>(State)];
+}
+
+void AItem::ApplyCollisionProfile(UPrimitiveComponent* Component, FName ProfileName)
+{
+	// Changing the profile recreates physics state, skip it when nothing changes
+	if (Component->GetCollisionProfileName() == ProfileName)
+		return;
+
+	Component->SetCollisionProfileName(ProfileName);
+	INC_DWORD_STAT(STAT_ItemCollisionProfileChanges);
 }
 
 void AItem::EndItemInterping()
@@ -204,61 +169,85 @@ void AItem::EndItemInterping()
 	SetActorScale3D(FVector(1.0f));
 }
 
-void AItem::ItemInterp(float DeltaTime)
+void AItem::CancelItemInterping()
 {
-	if (!bInterping)
-		return;
+	bInterping = false;
+	Character = nullptr;
+	SetActorScale3D(FVector(1.0f));
 
-	if (Character && ItemZCurve)
-	{
-		// Elapsed time since we started ItemInterpTimer
-		const float ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
-		// Get curve value corresponding to elapsed time	 
-		const float CurveValue = ItemZCurve->GetFloatValue(ElapsedTime);
-
-		// Get the initial location when the curve started
-		FVector ItemLocation = ItemInterpStartLocation;
-		// Get location in front of the camera 
-		const FVector CameraInterpLocation = Character->GetCameraInterpLocation();
-
-		// Vector from item to interpolation location, X and Y are zeroed out
-		const FVector ItemToCamera(0.0f, 0.0f, (CameraInterpLocation - ItemLocation).Z);
-		// Scale factor to multiply with CurveValue
-		const float DeltaZ = ItemToCamera.Size();
-
-		const FVector CurrentLocation = GetActorLocation();
-		// Interpolated X and Y value
-		const float InterpXValue = FMath::FInterpTo(CurrentLocation.X, CameraInterpLocation.X, DeltaTime, 30.0f);
-		const float InterpYValue = FMath::FInterpTo(CurrentLocation.Y, CameraInterpLocation.Y, DeltaTime, 30.0f);
-
-		// Set X and Y of ItemLocation to interpolated location
-		ItemLocation.X = InterpXValue;
-		ItemLocation.Y = InterpYValue;
-
-		// Update the Z location of the item with respect to the CurveValue and DeltaZ
-		ItemLocation.Z += CurveValue * DeltaZ;
-
-		SetActorLocation(ItemLocation, true, nullptr, ETeleportType::TeleportPhysics);
-
-		// Camera rotation this frame
-		const FRotator CameraRotation(Character->GetFollowCamera()->GetComponentRotation());
-
-		// Item Rotation's yaw is set to the camera's new yaw value + offset
-		FRotator ItemRotation(0.0f, CameraRotation.Yaw + InterpInitialYawOffset, 0.0f);
-		SetActorRotation(ItemRotation, ETeleportType::TeleportPhysics);
-
-		if (ItemScaleCurve)
-		{
-			const float ScaleCurveValue = ItemScaleCurve->GetFloatValue(ElapsedTime);
-			SetActorScale3D(FVector(ScaleCurveValue));
-		}
-	}
+	// Back on the ground for anyone else to pick up
+	SetItemState(EItemState::EIS_Pickup);
 }
 
 void AItem::SetItemState(EItemState itemState)
 {
 	ItemState = itemState;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AItem, ItemState, this);
+
 	SetItemProperties(itemState);
+	UpdateProximityRegistration();
+	UpdateMovementReplication();
+	UpdateNetDormancy();
+}
+
+void AItem::SetItemCount(int32 Count)
+{
+	ItemCount = Count;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AItem, ItemCount, this);
+	FlushNetDormancy();
+}
+
+void AItem::SetItemDefinition(UItemDefinition* Definition)
+{
+	ItemDefinition = Definition;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AItem, ItemDefinition, this);
+	FlushNetDormancy();
+}
+
+void AItem::UpdateNetDormancy()
+{
+	if (!HasAuthority())
+		return;
+
+	if ((ItemState == EItemState::EIS_Pickup || bParkedInPool) && CVarItemDormancy.GetValueOnGameThread() != 0)
+	{
+		// Send the final state once, then stop considering the item
+		SetNetDormancy(DORM_DormantAll);
+		FlushNetDormancy();
+	}
+	else
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+}
+
+void AItem::UpdateMovementReplication()
+{
+	if (!HasAuthority())
+		return;
+
+	// Falling and interpolating items are moved by the server, held ones follow their owner's attachment
+	SetReplicatingMovement(ItemState == EItemState::EIS_Falling || ItemState == EItemState::EIS_EquipInterping);
+
+	// Dropped and recycled items come to rest where clients can't follow, the dormancy flush carries the final place
+	if (ItemState == EItemState::EIS_Pickup)
+	{
+		RestingMovement.Location = GetActorLocation();
+		RestingMovement.Rotation = GetActorRotation();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AItem, RestingMovement, this);
+	}
+}
+
+void AItem::UpdateProximityRegistration()
+{
+	UItemProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UItemProximitySubsystem>();
+	if (!ProximitySubsystem)
+		return;
+
+	if (ItemState == EItemState::EIS_Pickup)
+		ProximitySubsystem->RegisterItem(this, AreaSphere->GetScaledSphereRadius());
+	else
+		ProximitySubsystem->UnregisterItem(this);
 }
 
 void AItem::StartItemInterping(AShooterCharacter* ShooterChar)
@@ -268,13 +257,70 @@ void AItem::StartItemInterping(AShooterCharacter* ShooterChar)
 	bInterping = true;
 	SetItemState(EItemState::EIS_EquipInterping);
 
-	GetWorldTimerManager().SetTimer(ItemInterpTimer, this, &AItem::EndItemInterping, ZCurveTime);
-
 	// Get initial yaw of the camera and the item
 	const float CameraRotationYaw = Character->GetFollowCamera()->GetComponentRotation().Yaw;
 	const float ItemRotationYaw = GetActorRotation().Yaw;
 
 	// Calculate the initial yaw offset between camera and item
-	InterpInitialYawOffset = ItemRotationYaw - CameraRotationYaw;
+	const float InterpInitialYawOffset = ItemRotationYaw - CameraRotationYaw;
+
+	// The subsystem moves the item and calls EndItemInterping after ZCurveTime
+	if (UItemInterpSubsystem* InterpSubsystem = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+		InterpSubsystem->StartInterping(this, Character, InterpInitialYawOffset);
+}
+
+
+void AItem::OnReleasedToPool()
+{
+	if (bInterping)
+	{
+		if (UItemInterpSubsystem* InterpSubsystem = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+			InterpSubsystem->StopInterping(this);
+		bInterping = false;
+	}
+	Character = nullptr;
+
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	if (ItemMesh->IsSimulatingPhysics())
+		ItemMesh->SetSimulatePhysics(false);
+
+	bParkedInPool = true;
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	// PickedUp leaves the components alone and takes the item out of the proximity registry
+	SetItemState(EItemState::EIS_PickedUp);
+}
+
+void AItem::OnAcquiredFromPool()
+{
+	const AItem* Defaults = GetClass()->GetDefaultObject<AItem>();
+	if (ItemDefinition != Defaults->ItemDefinition)
+		SetItemDefinition(Defaults->ItemDefinition);
+	if (ItemCount != Defaults->ItemCount)
+		SetItemCount(Defaults->ItemCount);
+	SetActorScale3D(Defaults->GetRootComponent()->GetRelativeScale3D());
+
+	bParkedInPool = false;
+	SetActorEnableCollision(true);
+	SetActorHiddenInGame(false);
+	SetItemState(EItemState::EIS_Pickup);
 }
 
+#if WITH_EDITOR
+void AItem::CopyLegacyItemValues(UItemDefinition* Definition) const
+{
+	Definition->ItemName = ItemName_DEPRECATED;
+	Definition->ItemRarity = ItemRarity_DEPRECATED;
+	Definition->ItemZCurve = ItemZCurve_DEPRECATED;
+	Definition->ZCurveTime = ZCurveTime_DEPRECATED;
+	Definition->ItemScaleCurve = ItemScaleCurve_DEPRECATED;
+}
+
+void AItem::SetLegacyItemDefinition(UItemDefinition* Definition)
+{
+	// Marks the blueprint or external actor package dirty, the migration is kept by saving it
+	Modify();
+	ItemDefinition = Definition;
+}
+#endif
@@ -4,20 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "ItemDefinition.h"
 #include "Item.generated.h"
 
-UENUM(BlueprintType)
-enum class EItemRarity : uint8
-{
-	EIR_Damaged UMETA(DisplayName = "Damaged"),
-	EIR_Common UMETA(DisplayName = "Common"),
-	EIR_Uncommon UMETA(DisplayName = "Uncommon"),
-	EIR_Rare UMETA(DisplayName = "Rare"),
-	EIR_Legendary UMETA(DisplayName = "Legendary"),
-
-	EIR_MAX UMETA(DisplayName = "DefaultMax")
-};
-
 UENUM(BlueprintType)
 enum class EItemState : uint8
 {
@@ -30,6 +19,16 @@ enum class EItemState : uint8
 	EIR_MAX UMETA(DisplayName = "DefaultMax")
 };
 
+// Collision profiles and physics flags the item components use in one state
+struct FItemStateProfile
+{
+	// False for states which leave the components untouched
+	bool bApply;
+	FName MeshProfile;
+	FName BoxProfile;
+	bool bSimulatePhysics;
+};
+
 UCLASS()
 class SHOOTER_API AItem : public AActor
 {
@@ -43,29 +42,35 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	// Called when overlapping area sphere
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Applies the replicated state on clients
 	UFUNCTION()
-	void OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	void OnRep_ItemState();
 
-	// Called when end overlapping area sphere
+	// Moves the item to where it came to rest on the server
 	UFUNCTION()
-	void OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	void OnRep_RestingMovement();
 
-	void SetActiveStars();
-	
-	// Sets the properties of the Item's components based on State
-	void SetItemProperties(EItemState State);
+	// Keeps the item dormant while it rests in the Pickup state, awake otherwise
+	void UpdateNetDormancy();
 
-	// Called when the timer expires
-	void EndItemInterping();
+	// Replicates movement only while the server moves the item, and sends the resting place once it lies on the ground
+	void UpdateMovementReplication();
 
-	// Handles item interpolation when in the EquipInterping state
-	void ItemInterp(float DeltaTime);
+	// Adds the item to the proximity registry while in the Pickup state, removes it otherwise
+	void UpdateProximityRegistration();
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// Sets the properties of the Item's components based on State
+	void SetItemProperties(EItemState State);
+
+	// Returns the precomputed component setup for State
+	static const FItemStateProfile& GetItemStateProfile(EItemState State);
 
+	// Sets the collision profile of Component unless it already uses it
+	static void ApplyCollisionProfile(UPrimitiveComponent* Component, FName ProfileName);
 
 private:
 	// Skeletal mesh for the item	
@@ -76,36 +81,25 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	class UBoxComponent* CollisionBox;
 
+	// Pickup radius of the item, has no collision and is only read by the proximity registry
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	class USphereComponent* AreaSphere;
 	
-	// Popup widget for when the player looks at the item
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	class UWidgetComponent* PickupWidget;
-	
-	// The name which appears on the pickup widget
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	FString ItemName;
+	// Name, rarity and interpolation curves shared by every item of this type
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
+	UItemDefinition* ItemDefinition;
 
-	// The name which appears on the pickup widget
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
+	// The count which appears on the pickup widget
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	int32 ItemCount;
 
-	// Item rarity determines the stars of the item
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	EItemRarity ItemRarity;
-
-	// The boolean array of item stars, representing which ones should be visible at the selected rarity
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	TArray<bool> ItemStars;
-
 	// State of the item
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_ItemState, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	EItemState ItemState;
 	
-	// The curve for Z axis of items
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	class UCurveFloat* ItemZCurve;
+	// Location and rotation of the item when it last entered the Pickup state
+	UPROPERTY(ReplicatedUsing = OnRep_RestingMovement)
+	FRepMovement RestingMovement;
 
 	// The start location when interpolation begins 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
@@ -119,36 +113,82 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	bool bInterping;
 
-	// Plays when we start interpolating
-	FTimerHandle ItemInterpTimer;
-
 	// Pointer to the shooter character
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	class AShooterCharacter* Character;	
 
-	// Duration of the curve and the timer
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	float ZCurveTime;
+	// True while the item waits hidden in UItemPoolSubsystem
+	bool bParkedInPool;
+
+#if WITH_EDITORONLY_DATA
+	// Values item blueprints and placed items set before UItemDefinition existed. Only loaded so that
+	// Shooter.Items.MigrateDefinitions can move them into definition assets, never saved again
+	UPROPERTY()
+	FString ItemName_DEPRECATED;
+
+	UPROPERTY()
+	EItemRarity ItemRarity_DEPRECATED;
+
+	UPROPERTY()
+	UCurveFloat* ItemZCurve_DEPRECATED;
 
-	// Initial yaw offset between the camera and the interpolating item
-	float InterpInitialYawOffset;
+	UPROPERTY()
+	float ZCurveTime_DEPRECATED;
 
-	// Curve used to scale item when interpolating
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* ItemScaleCurve;
+	UPROPERTY()
+	UCurveFloat* ItemScaleCurve_DEPRECATED;
+#endif
 
 public:
 	// Getters
-	FORCEINLINE UWidgetComponent* GetPickupWidget() const { return PickupWidget; }
+	FORCEINLINE const UItemDefinition* GetItemDefinition() const { return ItemDefinition ? ItemDefinition : GetDefault<UItemDefinition>(); }
+	FORCEINLINE int32 GetItemCount() const { return ItemCount; }
+	FORCEINLINE uint8 GetItemStarMask() const { return GetRarityStarMask(GetItemDefinition()->ItemRarity); }
 	FORCEINLINE USkeletalMeshComponent* GetItemMesh() const { return ItemMesh; }
 	FORCEINLINE UBoxComponent* GetCollisionBox() const { return CollisionBox; }
 	FORCEINLINE USphereComponent* GetAreaSphere() const { return AreaSphere; }
 	FORCEINLINE EItemState GetItemState() const { return ItemState; }
+	FORCEINLINE bool IsParkedInPool() const { return bParkedInPool; }
+	FORCEINLINE UCurveFloat* GetItemZCurve() const { return GetItemDefinition()->ItemZCurve; }
+	FORCEINLINE UCurveFloat* GetItemScaleCurve() const { return GetItemDefinition()->ItemScaleCurve; }
+	FORCEINLINE float GetZCurveTime() const { return GetItemDefinition()->ZCurveTime; }
+
+	UFUNCTION(BlueprintPure, Category = "Item Properties")
+	FString GetItemName() const { return GetItemDefinition()->ItemName; }
+
+	UFUNCTION(BlueprintPure, Category = "Item Properties")
+	EItemRarity GetItemRarity() const { return GetItemDefinition()->ItemRarity; }
+
+	// True when star Index (0 to 4) should be visible at the item's rarity
+	UFUNCTION(BlueprintPure, Category = "Item Properties")
+	bool IsStarActive(int32 Index) const { return Index >= 0 && Index < 8 && (GetItemStarMask() & (1 << Index)) != 0; }
 
 	// Setters
 	void SetItemState(EItemState itemState);
+	void SetItemCount(int32 Count);
+	void SetItemDefinition(UItemDefinition* Definition);
 
 	// Utilities
-	// Called from shooter character to start the timer
+	// Called from shooter character to start interpolating towards its camera
 	void StartItemInterping(AShooterCharacter* ShooterChar);
+
+	// Called from the interp subsystem when the curve has finished
+	void EndItemInterping();
+
+	// Called from the interp subsystem when the character the item flies to is gone, drops the item where it is
+	void CancelItemInterping();
+
+	// Called from the item pool when the item is parked, hides it and drops everything it was doing
+	virtual void OnReleasedToPool();
+
+	// Called from the item pool before the item is handed out again, restores its class defaults
+	virtual void OnAcquiredFromPool();
+
+#if WITH_EDITOR
+	// Copies the values the item had before UItemDefinition into Definition
+	void CopyLegacyItemValues(UItemDefinition* Definition) const;
+
+	// Points the item at the definition its old values were moved to
+	void SetLegacyItemDefinition(UItemDefinition* Definition);
+#endif
 };
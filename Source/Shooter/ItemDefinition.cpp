@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ItemDefinition.h"
+
+FPrimaryAssetId UItemDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(FPrimaryAssetType("ItemDefinition"), GetFName());
+}
+
+#if WITH_EDITOR
+#include "Shooter.h"
+#include "Item.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	// Scanned by the asset manager, see DefaultGame.ini
+	const FString ItemDefinitionFolder = TEXT("/Game/_Game/Items");
+
+	bool HasSameItemValues(const UItemDefinition* A, const UItemDefinition* B)
+	{
+		return A->ItemName == B->ItemName && A->ItemRarity == B->ItemRarity && A->ItemZCurve == B->ItemZCurve
+			&& A->ZCurveTime == B->ZCurveTime && A->ItemScaleCurve == B->ItemScaleCurve;
+	}
+
+	// Moves the old values of Item into the definition asset AssetName, unless it has a definition already or
+	// shares its values with its archetype, from which it then inherits the definition. Returns true when migrated
+	bool MigrateItem(AItem* Item, const FString& AssetName, UItemDefinition* Scratch, UItemDefinition* ArchetypeScratch)
+	{
+		const AItem* Archetype = Cast<AItem>(Item->GetArchetype());
+		if (!Archetype || Item->GetItemDefinition() != GetDefault<UItemDefinition>())
+			return false;
+
+		Item->CopyLegacyItemValues(Scratch);
+		Archetype->CopyLegacyItemValues(ArchetypeScratch);
+		if (HasSameItemValues(Scratch, ArchetypeScratch))
+			return false;
+
+		// Running the migration again reuses the assets of the last run
+		const FString PackageName = ItemDefinitionFolder / AssetName;
+		UItemDefinition* Definition = LoadObject<UItemDefinition>(nullptr, *(PackageName + TEXT(".") + AssetName), nullptr, LOAD_NoWarn | LOAD_Quiet);
+		if (!Definition)
+		{
+			UPackage* Package = CreatePackage(*PackageName);
+			Definition = NewObject<UItemDefinition>(Package, *AssetName, RF_Public | RF_Standalone);
+			Item->CopyLegacyItemValues(Definition);
+			FAssetRegistryModule::AssetCreated(Definition);
+			Package->MarkPackageDirty();
+		}
+
+		Item->SetLegacyItemDefinition(Definition);
+		UE_LOG(LogShooter, Display, TEXT("Item definitions: %s now uses %s"), *Item->GetPathName(), *Definition->GetPathName());
+		return true;
+	}
+}
+
+static FAutoConsoleCommandWithWorld GMigrateItemDefinitionsCommand(
+	TEXT("Shooter.Items.MigrateDefinitions"),
+	TEXT("Editor only. Moves the name, rarity and curves which item blueprints and items placed in the open level set before ")
+	TEXT("UItemDefinition into definition assets under /Game/_Game/Items. Save all afterwards to keep the result"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!GIsEditor)
+			return;
+
+		UItemDefinition* Scratch = NewObject<UItemDefinition>(GetTransientPackage());
+		UItemDefinition* ArchetypeScratch = NewObject<UItemDefinition>(GetTransientPackage());
+		int32 NumMigrated = 0;
+
+		// Blueprints first, placed items compare against the blueprint values they were loaded with
+		TArray<FAssetData> Assets;
+		IAssetRegistry::GetChecked().GetAssetsByPath(FName("/Game/_Game"), Assets, true);
+		for (const FAssetData& AssetData : Assets)
+		{
+			if (AssetData.AssetClass != UBlueprint::StaticClass()->GetFName())
+				continue;
+
+			const UBlueprint* Blueprint = Cast<UBlueprint>(AssetData.GetAsset());
+			if (!Blueprint || !Blueprint->GeneratedClass || !Blueprint->GeneratedClass->IsChildOf<AItem>())
+				continue;
+
+			AItem* Defaults = Blueprint->GeneratedClass->GetDefaultObject<AItem>();
+			NumMigrated += MigrateItem(Defaults, TEXT("DA_") + Blueprint->GetName(), Scratch, ArchetypeScratch);
+		}
+
+		if (World)
+		{
+			for (TActorIterator<AItem> It(World); It; ++It)
+			{
+				const FString Label = MakeObjectNameFromDisplayLabel(It->GetActorLabel(), NAME_None).ToString();
+				NumMigrated += MigrateItem(*It, FString::Printf(TEXT("DA_%s_%s"), *World->GetName(), *Label), Scratch, ArchetypeScratch);
+			}
+		}
+
+		UE_LOG(LogShooter, Display, TEXT("Item definitions: %d items migrated"), NumMigrated);
+	}));
+#endif
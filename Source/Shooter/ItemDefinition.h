@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ItemDefinition.generated.h"
+
+UENUM(BlueprintType)
+enum class EItemRarity : uint8
+{
+	EIR_Damaged UMETA(DisplayName = "Damaged"),
+	EIR_Common UMETA(DisplayName = "Common"),
+	EIR_Uncommon UMETA(DisplayName = "Uncommon"),
+	EIR_Rare UMETA(DisplayName = "Rare"),
+	EIR_Legendary UMETA(DisplayName = "Legendary"),
+
+	EIR_MAX UMETA(DisplayName = "DefaultMax")
+};
+
+// Stars shown for Rarity, bit 0 is the first star
+constexpr uint8 GetRarityStarMask(EItemRarity Rarity)
+{
+	return Rarity < EItemRarity::EIR_MAX ? static_cast<uint8>((1 << (static_cast<uint8>(Rarity) + 1)) - 1) : 0;
+}
+
+/**
+ * Data shared by every instance of an item type. Items only hold a pointer to their
+ * definition, items without one use the defaults of this class
+ */
+UCLASS(BlueprintType)
+class SHOOTER_API UItemDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// The name which appears on the pickup widget
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties")
+	FString ItemName = FString("Default");
+
+	// Item rarity determines the stars of the item
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties")
+	EItemRarity ItemRarity = EItemRarity::EIR_Common;
+
+	// The curve for Z axis of items
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties")
+	class UCurveFloat* ItemZCurve = nullptr;
+
+	// Curve used to scale item when interpolating
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties")
+	UCurveFloat* ItemScaleCurve = nullptr;
+
+	// Duration of the interpolation curves
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties")
+	float ZCurveTime = 0.7f;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+};
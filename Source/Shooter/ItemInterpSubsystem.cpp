@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ItemInterpSubsystem.h"
+#include "Shooter.h"
+#include "Item.h"
+#include "ShooterCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Curves/CurveFloat.h"
+
+DECLARE_CYCLE_STAT(TEXT("ItemInterp"), STAT_ItemInterp, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interping Items"), STAT_InterpingItems, STATGROUP_Shooter);
+
+void UItemInterpSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Items.Num() == 0)
+		return;
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ItemInterp);
+	SET_DWORD_STAT(STAT_InterpingItems, Items.Num());
+
+	CurveSamples.Reset();
+	TargetViews.Reset();
+	FinishedItems.Reset();
+	CancelledItems.Reset();
+
+	for (int32 Index = Items.Num() - 1; Index >= 0; Index--)
+	{
+		AItem* Item = Items[Index];
+		AShooterCharacter* Target = Targets[Index];
+		if (!IsValid(Item) || !IsValid(Target))
+		{
+			RemoveAt(Index);
+			if (IsValid(Item))
+				CancelledItems.Add(Item);
+			continue;
+		}
+
+		const float ElapsedTime = ElapsedTimes[Index] += DeltaTime;
+		if (ElapsedTime >= Item->GetZCurveTime())
+		{
+			RemoveAt(Index);
+			FinishedItems.Add(Item);
+			continue;
+		}
+
+		if (!Item->GetItemZCurve())
+			continue;
+
+		// Camera values are shared by every item flying to the same character
+		const FItemInterpTargetView* View = TargetViews.FindByPredicate([Target](const FItemInterpTargetView& Other) { return Other.Target == Target; });
+		if (!View)
+			View = &TargetViews.Add_GetRef({ Target, Target->GetCameraInterpLocation(), Target->GetFollowCamera()->GetComponentRotation().Yaw });
+
+		// Get curve value corresponding to elapsed time	 
+		const float CurveValue = SampleCurve(Item->GetItemZCurve(), ElapsedTime);
+
+		// Get the initial location when the curve started
+		FVector ItemLocation = StartLocations[Index];
+
+		// Vector from item to interpolation location, X and Y are zeroed out
+		const FVector ItemToCamera(0.0f, 0.0f, (View->InterpLocation - ItemLocation).Z);
+		// Scale factor to multiply with CurveValue
+		const float DeltaZ = ItemToCamera.Size();
+
+		const FVector CurrentLocation = Item->GetActorLocation();
+		// Set X and Y of ItemLocation to interpolated location
+		ItemLocation.X = FMath::FInterpTo(CurrentLocation.X, View->InterpLocation.X, DeltaTime, 30.0f);
+		ItemLocation.Y = FMath::FInterpTo(CurrentLocation.Y, View->InterpLocation.Y, DeltaTime, 30.0f);
+
+		// Update the Z location of the item with respect to the CurveValue and DeltaZ
+		ItemLocation.Z += CurveValue * DeltaZ;
+
+		Item->SetActorLocation(ItemLocation, true, nullptr, ETeleportType::TeleportPhysics);
+
+		// Item Rotation's yaw is set to the camera's new yaw value + offset
+		Item->SetActorRotation(FRotator(0.0f, View->CameraYaw + YawOffsets[Index], 0.0f), ETeleportType::TeleportPhysics);
+
+		if (Item->GetItemScaleCurve())
+			Item->SetActorScale3D(FVector(SampleCurve(Item->GetItemScaleCurve(), ElapsedTime)));
+	}
+
+	// Finish outside the loop, picking up an item can start or stop other interpolations
+	for (AItem* Item : FinishedItems)
+		Item->EndItemInterping();
+
+	for (AItem* Item : CancelledItems)
+		Item->CancelItemInterping();
+
+	FinishedItems.Reset();
+	CancelledItems.Reset();
+}
+
+TStatId UItemInterpSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemInterpSubsystem, STATGROUP_Tickables);
+}
+
+void UItemInterpSubsystem::StartInterping(AItem* Item, AShooterCharacter* Target, float InitialYawOffset)
+{
+	if (!Item || !Target)
+		return;
+
+	// Restart from the beginning if the item was already moving
+	StopInterping(Item);
+
+	Items.Add(Item);
+	Targets.Add(Target);
+	StartLocations.Add(Item->GetActorLocation());
+	YawOffsets.Add(InitialYawOffset);
+	ElapsedTimes.Add(0.0f);
+}
+
+void UItemInterpSubsystem::StopInterping(AItem* Item)
+{
+	const int32 Index = Items.Find(Item);
+	if (Index != INDEX_NONE)
+		RemoveAt(Index);
+}
+
+void UItemInterpSubsystem::RemoveAt(int32 Index)
+{
+	Items.RemoveAtSwap(Index, 1, false);
+	Targets.RemoveAtSwap(Index, 1, false);
+	StartLocations.RemoveAtSwap(Index, 1, false);
+	YawOffsets.RemoveAtSwap(Index, 1, false);
+	ElapsedTimes.RemoveAtSwap(Index, 1, false);
+}
+
+float UItemInterpSubsystem::SampleCurve(const UCurveFloat* Curve, float Time)
+{
+	for (const FItemInterpCurveSample& Sample : CurveSamples)
+	{
+		if (Sample.Curve == Curve && Sample.Time == Time)
+			return Sample.Value;
+	}
+
+	const float Value = Curve->GetFloatValue(Time);
+	CurveSamples.Add({ Curve, Time, Value });
+	return Value;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemInterpSubsystem.generated.h"
+
+class AItem;
+class AShooterCharacter;
+class UCurveFloat;
+
+// A curve value evaluated during the current update
+struct FItemInterpCurveSample
+{
+	const UCurveFloat* Curve;
+	float Time;
+	float Value;
+};
+
+// Camera interpolation location and yaw of a character receiving items
+struct FItemInterpTargetView
+{
+	const AShooterCharacter* Target;
+	FVector InterpLocation;
+	float CameraYaw;
+};
+
+/**
+ * Drives every item in the EquipInterping state in one batched update, so items
+ * themselves never need to tick
+ */
+UCLASS()
+class SHOOTER_API UItemInterpSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts moving Item towards the camera of Target
+	void StartInterping(AItem* Item, AShooterCharacter* Target, float InitialYawOffset);
+
+	// Drops Item from the batch without finishing its interpolation
+	void StopInterping(AItem* Item);
+
+	FORCEINLINE int32 GetNumInterpingItems() const { return Items.Num(); }
+
+private:
+	void RemoveAt(int32 Index);
+
+	// Returns the value of Curve at Time, evaluating each curve once per distinct time per update
+	float SampleCurve(const UCurveFloat* Curve, float Time);
+
+	// Interping items and their per-item state, all arrays share the same index
+	UPROPERTY()
+	TArray<AItem*> Items;
+
+	UPROPERTY()
+	TArray<AShooterCharacter*> Targets;
+
+	TArray<FVector> StartLocations;
+	TArray<float> YawOffsets;
+	TArray<float> ElapsedTimes;
+
+	// Curve evaluations of the current update
+	TArray<FItemInterpCurveSample> CurveSamples;
+
+	// Camera values of each distinct target this update
+	TArray<FItemInterpTargetView> TargetViews;
+
+	// Items which reached the end of their curve this update
+	UPROPERTY(Transient)
+	TArray<AItem*> FinishedItems;
+
+	// Items whose target went away this update
+	UPROPERTY(Transient)
+	TArray<AItem*> CancelledItems;
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ItemPoolSubsystem.h"
+#include "Shooter.h"
+#include "Item.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AcquireItem"), STAT_AcquireItem, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Items Acquired"), STAT_ItemsAcquired, STATGROUP_Shooter);
+
+// Parked items wait far below the level, hidden and without collision
+static const FVector ItemPoolParkingLocation(0.0f, 0.0f, -100000.0f);
+
+void UItemPoolSubsystem::Deinitialize()
+{
+	// The world destroys the parked actors with everything else
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemPoolSubsystem::PrewarmClass(TSubclassOf<AItem> Class, int32 Count)
+{
+	if (!Class || Count <= 0 || IsClient())
+		return;
+
+	FItemPoolEntry& Entry = Pools.FindOrAdd(Class.Get());
+	Entry.Capacity = FMath::Max(Entry.Capacity, Count);
+
+	while (Entry.Free.Num() < Count)
+	{
+		AItem* Item = SpawnItem(Class.Get(), FTransform(ItemPoolParkingLocation));
+		if (!Item)
+			break;
+
+		Item->OnReleasedToPool();
+		Entry.Free.Add(Item);
+	}
+}
+
+AItem* UItemPoolSubsystem::AcquireItem(TSubclassOf<AItem> Class, const FTransform& Transform)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_AcquireItem);
+
+	if (!Class || IsClient())
+		return nullptr;
+
+	AItem* Item = nullptr;
+	if (FItemPoolEntry* Entry = Pools.Find(Class.Get()))
+	{
+		// Parked items can still be destroyed by the level, skip any which were
+		while (!Item && Entry->Free.Num() > 0)
+		{
+			AItem* Candidate = Entry->Free.Pop(false);
+			if (IsValid(Candidate))
+				Item = Candidate;
+		}
+	}
+
+	if (Item)
+	{
+		Item->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		Item->OnAcquiredFromPool();
+		Stats.Hits++;
+	}
+	else
+	{
+		Item = SpawnItem(Class.Get(), Transform);
+		Stats.Misses++;
+	}
+
+	if (Item)
+		INC_DWORD_STAT(STAT_ItemsAcquired);
+
+	return Item;
+}
+
+void UItemPoolSubsystem::ReleaseItem(AItem* Item)
+{
+	if (!IsValid(Item) || Item->IsParkedInPool() || IsClient())
+		return;
+
+	FItemPoolEntry& Entry = Pools.FindOrAdd(Item->GetClass());
+	if (Entry.Capacity <= 0)
+		Entry.Capacity = DefaultCapacity;
+
+	if (Entry.Free.Num() >= Entry.Capacity)
+	{
+		Item->Destroy();
+		Stats.Overflows++;
+		return;
+	}
+
+	Item->OnReleasedToPool();
+	Item->SetActorLocation(ItemPoolParkingLocation, false, nullptr, ETeleportType::ResetPhysics);
+	Entry.Free.Add(Item);
+	Stats.Releases++;
+}
+
+bool UItemPoolSubsystem::IsClient() const
+{
+	// Items replicate, clients see the server's actors come and go and must not park or spawn their own
+	const UWorld* World = GetWorld();
+	return World && World->GetNetMode() == NM_Client;
+}
+
+AItem* UItemPoolSubsystem::SpawnItem(UClass* Class, const FTransform& Transform)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+		return nullptr;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AItem>(Class, Transform, SpawnParameters);
+}
+
+static FAutoConsoleCommandWithWorld GItemPoolStatsCommand(
+	TEXT("Shooter.ItemPool.Stats"),
+	TEXT("Prints item pool hits, misses, releases and overflows"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UItemPoolSubsystem* ItemPool = World ? World->GetSubsystem<UItemPoolSubsystem>() : nullptr)
+		{
+			const FItemPoolStats& Stats = ItemPool->GetStats();
+			UE_LOG(LogShooter, Display, TEXT("Item Pool: %d hits, %d misses, %d releases, %d overflows"), Stats.Hits, Stats.Misses, Stats.Releases, Stats.Overflows);
+		}
+	}));
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "ItemPoolSubsystem.generated.h"
+
+class AItem;
+
+// Pool counters, accumulated since the last reset
+struct FItemPoolStats
+{
+	// Served from a parked item
+	int32 Hits = 0;
+
+	// No parked item, a new actor had to be spawned
+	int32 Misses = 0;
+
+	// Items parked for reuse
+	int32 Releases = 0;
+
+	// Released with the class already at its cap, the actor was destroyed
+	int32 Overflows = 0;
+};
+
+USTRUCT()
+struct FItemPoolEntry
+{
+	GENERATED_BODY()
+
+	// Parked items ready to be handed out
+	UPROPERTY()
+	TArray<AItem*> Free;
+
+	// Maximum number of parked items of this class
+	int32 Capacity = 0;
+};
+
+/**
+ * Recycles item and weapon actors so loot waves and weapon spawns don't pay for
+ * spawning and garbage collecting an actor with four components each time
+ */
+UCLASS()
+class SHOOTER_API UItemPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Spawns and parks items of Class until Count of them are free and uses Count as its capacity
+	void PrewarmClass(TSubclassOf<AItem> Class, int32 Count);
+
+	// Returns an item of Class at Transform in the Pickup state, reusing a parked one when possible
+	AItem* AcquireItem(TSubclassOf<AItem> Class, const FTransform& Transform);
+
+	template<class T>
+	T* AcquireItem(TSubclassOf<AItem> Class, const FTransform& Transform)
+	{
+		return Cast<T>(AcquireItem(Class, Transform));
+	}
+
+	// Hides Item, turns its collision off and keeps it for the next AcquireItem of its class
+	void ReleaseItem(AItem* Item);
+
+	FORCEINLINE int32 GetNumFree(TSubclassOf<AItem> Class) const
+	{
+		const FItemPoolEntry* Entry = Pools.Find(Class.Get());
+		return Entry ? Entry->Free.Num() : 0;
+	}
+
+	FORCEINLINE const FItemPoolStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = FItemPoolStats(); }
+
+private:
+	AItem* SpawnItem(UClass* Class, const FTransform& Transform);
+
+	// True in a client world, where the pool does nothing
+	bool IsClient() const;
+
+	// Capacity used for classes which were never prewarmed
+	int32 DefaultCapacity = 64;
+
+	UPROPERTY()
+	TMap<UClass*, FItemPoolEntry> Pools;
+
+	FItemPoolStats Stats;
+};
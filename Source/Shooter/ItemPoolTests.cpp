@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ItemPoolSubsystem.h"
+#include "Item.h"
+#include "ShooterTestWorld.h"
+
+namespace
+{
+	// Items spawned and released on each path
+	constexpr int32 ItemPoolTestCount = 10000;
+
+	// Spawn latency percentiles of Samples, which are in cycles
+	FString FormatSpawnLatency(const TCHAR* Label, TArray<uint64>& Samples)
+	{
+		Samples.Sort();
+		auto Percentile = [&Samples](float Fraction)
+		{
+			const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1);
+			return FPlatformTime::ToMilliseconds64(Samples[Index]) * 1000.0;
+		};
+
+		return FString::Printf(TEXT("%s: %d spawns, P50 %.1f us, P90 %.1f us, P99 %.1f us, Max %.1f us"),
+			Label, Samples.Num(), Percentile(0.5f), Percentile(0.9f), Percentile(0.99f), Percentile(1.0f));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemPoolSpawnLatencyTest, "Shooter.ItemPool.SpawnLatency", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FItemPoolSpawnLatencyTest::RunTest(const FString& Parameters)
+{
+	// Every actor spawned below is destroyed with the world
+	FShooterTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UItemPoolSubsystem* ItemPool = World->GetSubsystem<UItemPoolSubsystem>();
+	if (!TestNotNull(TEXT("Item pool subsystem"), ItemPool))
+		return false;
+
+	const FTransform SpawnTransform(FVector(0.0f, 0.0f, -50000.0f));
+	TArray<AItem*> Spawned;
+	Spawned.Reserve(ItemPoolTestCount);
+	TArray<uint64> Samples;
+	Samples.Reserve(ItemPoolTestCount);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Direct: every item is a fresh actor which is destroyed afterwards
+	for (int32 Index = 0; Index < ItemPoolTestCount; Index++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		AItem* Item = World->SpawnActor<AItem>(AItem::StaticClass(), SpawnTransform, SpawnParameters);
+		Samples.Add(FPlatformTime::Cycles64() - StartCycles);
+		Spawned.Add(Item);
+	}
+	for (AItem* Item : Spawned)
+	{
+		if (Item)
+			Item->Destroy();
+	}
+	AddInfo(FormatSpawnLatency(TEXT("Direct"), Samples));
+
+	// Pooled: the pool is filled up front, the latency is that of a warm respawn wave
+	Spawned.Reset();
+	Samples.Reset();
+	ItemPool->PrewarmClass(AItem::StaticClass(), ItemPoolTestCount);
+	ItemPool->ResetStats();
+	for (int32 Index = 0; Index < ItemPoolTestCount; Index++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		AItem* Item = ItemPool->AcquireItem(AItem::StaticClass(), SpawnTransform);
+		Samples.Add(FPlatformTime::Cycles64() - StartCycles);
+		Spawned.Add(Item);
+	}
+	AddInfo(FormatSpawnLatency(TEXT("Pooled"), Samples));
+
+	TestEqual(TEXT("Every acquire is served from the prewarmed pool"), ItemPool->GetStats().Hits, ItemPoolTestCount);
+	const int32 NumNotOnGround = Spawned.FilterByPredicate([](const AItem* Item)
+	{
+		return !Item || Item->IsParkedInPool() || Item->GetItemState() != EItemState::EIS_Pickup;
+	}).Num();
+	TestEqual(TEXT("Acquired items lie on the ground"), NumNotOnGround, 0);
+
+	for (AItem* Item : Spawned)
+		ItemPool->ReleaseItem(Item);
+
+	TestEqual(TEXT("Released items are parked for reuse"), ItemPool->GetNumFree(AItem::StaticClass()), ItemPoolTestCount);
+	TestEqual(TEXT("The prewarmed capacity holds every released item"), ItemPool->GetStats().Overflows, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ItemProximitySubsystem.h"
+#include "Item.h"
+
+void UItemProximitySubsystem::RegisterItem(const AItem* Item, float Radius)
+{
+	if (!Item)
+		return;
+
+	UnregisterItem(Item);
+
+	const FVector Location = Item->GetActorLocation();
+	const FIntVector Cell = GetCell(Location);
+
+	Cells.FindOrAdd(Cell).Add({ Item, Location, Radius });
+	ItemCells.Add(Item, Cell);
+	MaxItemRadius = FMath::Max(MaxItemRadius, Radius);
+}
+
+void UItemProximitySubsystem::UnregisterItem(const AItem* Item)
+{
+	FIntVector Cell;
+	if (!ItemCells.RemoveAndCopyValue(Item, Cell))
+		return;
+
+	if (TArray<FItemProximityEntry>* Entries = Cells.Find(Cell))
+	{
+		Entries->RemoveAllSwap([Item](const FItemProximityEntry& Entry) { return Entry.Item == Item; }, false);
+		if (Entries->Num() == 0)
+			Cells.Remove(Cell);
+	}
+}
+
+int32 UItemProximitySubsystem::CountItemsNear(const FVector& Location, float QueryRadius) const
+{
+	if (ItemCells.Num() == 0)
+		return 0;
+
+	// Every cell which could hold an item reaching the query sphere
+	const FVector Extent(QueryRadius + MaxItemRadius);
+	const FIntVector MinCell = GetCell(Location - Extent);
+	const FIntVector MaxCell = GetCell(Location + Extent);
+
+	int32 Count = 0;
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<FItemProximityEntry>* Entries = Cells.Find(FIntVector(X, Y, Z));
+				if (!Entries)
+					continue;
+
+				for (const FItemProximityEntry& Entry : *Entries)
+				{
+					if (FVector::DistSquared(Location, Entry.Location) <= FMath::Square(Entry.Radius + QueryRadius))
+						Count++;
+				}
+			}
+		}
+	}
+
+	return Count;
+}
+
+FIntVector UItemProximitySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(static_cast<float>(Location.X / CellSize)),
+		FMath::FloorToInt(static_cast<float>(Location.Y / CellSize)),
+		FMath::FloorToInt(static_cast<float>(Location.Z / CellSize)));
+}
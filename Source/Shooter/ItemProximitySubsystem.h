@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemProximitySubsystem.generated.h"
+
+class AItem;
+
+// A pickup item as stored in a grid cell
+struct FItemProximityEntry
+{
+	const AItem* Item;
+	FVector Location;
+	float Radius;
+};
+
+/**
+ * Uniform spatial hash of the items lying around in the Pickup state, lets characters
+ * find nearby items without physics overlaps
+ */
+UCLASS()
+class SHOOTER_API UItemProximitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Adds Item at its current location, or moves it there if already registered
+	void RegisterItem(const AItem* Item, float Radius);
+
+	void UnregisterItem(const AItem* Item);
+
+	// Number of items whose pickup radius reaches a sphere of QueryRadius around Location
+	int32 CountItemsNear(const FVector& Location, float QueryRadius) const;
+
+	FORCEINLINE int32 GetNumRegisteredItems() const { return ItemCells.Num(); }
+
+private:
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Edge length of a grid cell
+	float CellSize = 500.0f;
+
+	// Largest pickup radius registered so far, widens the cell range of queries
+	float MaxItemRadius = 0.0f;
+
+	TMap<FIntVector, TArray<FItemProximityEntry>> Cells;
+
+	// Cell each registered item lives in
+	TMap<const AItem*, FIntVector> ItemCells;
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ItemProximitySubsystem.h"
+#include "Item.h"
+#include "ShooterTestWorld.h"
+#include "Components/SphereComponent.h"
+
+namespace
+{
+	constexpr int32 ProximityTestItems = 5000;
+	constexpr int32 ProximityTestCharacters = 64;
+	constexpr int32 ProximityTestFrames = 120;
+
+	// Items lie on a grid of this spacing, 50 rows of 100
+	constexpr float ProximityTestSpacing = 100.0f;
+
+	// Half height of the default character capsule, the radius characters query with
+	constexpr float ProximityTestQueryRadius = 88.0f;
+
+	// Where character Index stands on Frame, every character runs its own circle across the loot
+	FVector GetCharacterLocation(int32 Index, int32 Frame)
+	{
+		const FVector Center((Index % 8 + 0.5f) * 1250.0f, (Index / 8 + 0.5f) * 625.0f, 0.0f);
+		const float Angle = Index + Frame * 0.05f;
+		return Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * 400.0f;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemProximityCostTest, "Shooter.ItemProximity.QueryCost", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FItemProximityCostTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UItemProximitySubsystem* Proximity = World->GetSubsystem<UItemProximitySubsystem>();
+	if (!TestNotNull(TEXT("Item proximity subsystem"), Proximity))
+		return false;
+
+	// Items register themselves in BeginPlay since they start out in the Pickup state
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	TArray<AItem*> Items;
+	Items.Reserve(ProximityTestItems);
+	for (int32 Index = 0; Index < ProximityTestItems; Index++)
+	{
+		const FVector Location((Index % 100) * ProximityTestSpacing, (Index / 100) * ProximityTestSpacing, 0.0f);
+		if (AItem* Item = World->SpawnActor<AItem>(AItem::StaticClass(), FTransform(Location), SpawnParameters))
+			Items.Add(Item);
+	}
+	TestEqual(TEXT("Every item on the ground is registered"), Proximity->GetNumRegisteredItems(), ProximityTestItems);
+
+	// Registry: what every character asks each tick now
+	int64 RegistryCount = 0;
+	uint64 RegistryCycles = 0;
+	for (int32 Frame = 0; Frame < ProximityTestFrames; Frame++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < ProximityTestCharacters; Index++)
+			RegistryCount += Proximity->CountItemsNear(GetCharacterLocation(Index, Frame), ProximityTestQueryRadius);
+		RegistryCycles += FPlatformTime::Cycles64() - StartCycles;
+	}
+
+	// Overlaps: the area spheres get their query collision back, as before the registry, and every
+	// character runs a sphere overlap against them. This leaves out the overlap event bookkeeping
+	// of moving bodies, so it is a lower bound of the old cost
+	for (AItem* Item : Items)
+	{
+		USphereComponent* AreaSphere = Item->GetAreaSphere();
+		AreaSphere->SetCollisionObjectType(ECC_WorldDynamic);
+		AreaSphere->SetCollisionResponseToAllChannels(ECR_Overlap);
+		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	}
+
+	const FCollisionShape QueryShape = FCollisionShape::MakeSphere(ProximityTestQueryRadius);
+	TArray<FOverlapResult> Overlaps;
+	int64 OverlapCount = 0;
+	uint64 OverlapCycles = 0;
+	for (int32 Frame = 0; Frame < ProximityTestFrames; Frame++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < ProximityTestCharacters; Index++)
+		{
+			Overlaps.Reset();
+			World->OverlapMultiByObjectType(Overlaps, GetCharacterLocation(Index, Frame), FQuat::Identity, FCollisionObjectQueryParams(ECC_WorldDynamic), QueryShape);
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				const AItem* Item = Cast<AItem>(Overlap.GetActor());
+				if (Item && Overlap.GetComponent() == Item->GetAreaSphere())
+					OverlapCount++;
+			}
+		}
+		OverlapCycles += FPlatformTime::Cycles64() - StartCycles;
+	}
+
+	const int32 NumQueries = ProximityTestFrames * ProximityTestCharacters;
+	AddInfo(FString::Printf(TEXT("%d items, %d characters, %d frames"), ProximityTestItems, ProximityTestCharacters, ProximityTestFrames));
+	AddInfo(FString::Printf(TEXT("Registry: %.3f ms/frame, %.2f us/query, %lld items found"),
+		FPlatformTime::ToMilliseconds64(RegistryCycles) / ProximityTestFrames, FPlatformTime::ToMilliseconds64(RegistryCycles) * 1000.0 / NumQueries, RegistryCount));
+	AddInfo(FString::Printf(TEXT("Sphere overlaps: %.3f ms/frame, %.2f us/query, %lld items found"),
+		FPlatformTime::ToMilliseconds64(OverlapCycles) / ProximityTestFrames, FPlatformTime::ToMilliseconds64(OverlapCycles) * 1000.0 / NumQueries, OverlapCount));
+
+	// Both find the same items, up to contacts right on the edge of a sphere
+	TestTrue(TEXT("The registry finds the items the overlaps find"), FMath::Abs(RegistryCount - OverlapCount) <= FMath::Max<int64>(OverlapCount / 100, 1));
+	TestTrue(TEXT("The characters walk through loot"), RegistryCount > 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Item.h"
+#include "ShooterTestWorld.h"
+#include "Components/BoxComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+namespace
+{
+	constexpr int32 ItemStateTestItems = 100;
+	constexpr int32 ItemStateTestTransitions = 10000;
+
+	// What weapons go through in play: picked up, equipped, dropped and landed, then picked up into the inventory
+	// and equipped twice in a row as a swap does
+	const EItemState ItemStateTestCycle[] =
+	{
+		EItemState::EIS_EquipInterping,
+		EItemState::EIS_Equipped,
+		EItemState::EIS_Falling,
+		EItemState::EIS_Pickup,
+		EItemState::EIS_EquipInterping,
+		EItemState::EIS_PickedUp,
+		EItemState::EIS_Equipped,
+		EItemState::EIS_Equipped,
+		EItemState::EIS_Falling,
+		EItemState::EIS_Pickup,
+	};
+
+	// Collision and physics setup of the item components, compared before and after each transition
+	struct FItemPhysicsSnapshot
+	{
+		FName MeshProfile;
+		FName BoxProfile;
+		bool bMeshSimulating;
+		FPhysicsActorHandle MeshBody;
+		FPhysicsActorHandle BoxBody;
+
+		explicit FItemPhysicsSnapshot(const AItem* Item)
+			: MeshProfile(Item->GetItemMesh()->GetCollisionProfileName()), BoxProfile(Item->GetCollisionBox()->GetCollisionProfileName()),
+			bMeshSimulating(Item->GetItemMesh()->IsSimulatingPhysics()),
+			MeshBody(Item->GetItemMesh()->GetBodyInstance() ? Item->GetItemMesh()->GetBodyInstance()->GetPhysicsActorHandle() : FPhysicsActorHandle()),
+			BoxBody(Item->GetCollisionBox()->GetBodyInstance()->GetPhysicsActorHandle())
+		{
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemStateTransitionTest, "Shooter.Item.StateTransitions", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FItemStateTransitionTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	TArray<AItem*> Items;
+	for (int32 Index = 0; Index < ItemStateTestItems; Index++)
+	{
+		if (AItem* Item = World->SpawnActor<AItem>(AItem::StaticClass(), FTransform(FVector(Index * 200.0f, 0.0f, 0.0f)), SpawnParameters))
+			Items.Add(Item);
+	}
+	if (!TestEqual(TEXT("Every item spawned"), Items.Num(), ItemStateTestItems))
+		return false;
+
+	// Timed on their own, the snapshots below cost more than the transitions
+	const int32 TransitionsPerItem = ItemStateTestTransitions / ItemStateTestItems;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (AItem* Item : Items)
+	{
+		for (int32 Transition = 0; Transition < TransitionsPerItem; Transition++)
+			Item->SetItemState(ItemStateTestCycle[Transition % UE_ARRAY_COUNT(ItemStateTestCycle)]);
+	}
+	const double TransitionMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	// Same transitions again, counting what each one changed on the components
+	int32 ProfileChanges = 0;
+	int32 SimulationChanges = 0;
+	int32 BodyRecreations = 0;
+	int32 RepeatedStateChanges = 0;
+	for (AItem* Item : Items)
+	{
+		for (int32 Transition = 0; Transition < TransitionsPerItem; Transition++)
+		{
+			const EItemState State = ItemStateTestCycle[Transition % UE_ARRAY_COUNT(ItemStateTestCycle)];
+			const bool bRepeated = Item->GetItemState() == State;
+			const FItemPhysicsSnapshot Before(Item);
+			Item->SetItemState(State);
+			const FItemPhysicsSnapshot After(Item);
+
+			const int32 Changes = (Before.MeshProfile != After.MeshProfile) + (Before.BoxProfile != After.BoxProfile);
+			ProfileChanges += Changes;
+			SimulationChanges += Before.bMeshSimulating != After.bMeshSimulating;
+			BodyRecreations += (Before.MeshBody != After.MeshBody) + (Before.BoxBody != After.BoxBody);
+			if (bRepeated)
+				RepeatedStateChanges += Changes + (Before.bMeshSimulating != After.bMeshSimulating);
+		}
+	}
+
+	const int32 NumTransitions = TransitionsPerItem * Items.Num();
+	AddInfo(FString::Printf(TEXT("%d transitions in %.3f ms, %.2f us each"), NumTransitions, TransitionMs, TransitionMs * 1000.0 / NumTransitions));
+	AddInfo(FString::Printf(TEXT("%d collision profile changes, %d simulation toggles, %d physics bodies recreated"),
+		ProfileChanges, SimulationChanges, BodyRecreations));
+
+	// Per pass of the cycle the box loses and regains the trace profile twice, the mesh does the same with the falling one
+	const int32 NumCycles = NumTransitions / UE_ARRAY_COUNT(ItemStateTestCycle);
+	TestEqual(TEXT("Only profiles which differ are applied"), ProfileChanges, NumCycles * 8);
+	TestEqual(TEXT("Entering the state the item is already in changes nothing"), RepeatedStateChanges, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LagCompensationSubsystem.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+// Sphere radii of the hitbox bones
+static constexpr float HitboxBoneRadii[NumHitboxBones] = { 15.0f, 25.0f, 20.0f };
+
+// Bone names of the hitboxes, head first so it wins ties
+static const FName& GetHitboxBoneName(int32 Bone)
+{
+	static const FName BoneNames[NumHitboxBones] = { FName("head"), FName("spine_03"), FName("pelvis") };
+	return BoneNames[Bone];
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only the server validates shots
+	if (GetWorld()->GetNetMode() == NM_Client)
+		return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = 0; Index < Characters.Num(); Index++)
+	{
+		const AShooterCharacter* Character = Characters[Index].Get();
+		if (!Character)
+			continue;
+
+		// Overwrite the oldest slot, the storage never grows after registration
+		FHitboxHistory& History = Histories[Index];
+		RecordSnapshot(Character, Now, History.Snapshots[History.Head]);
+		History.Head = (History.Head + 1) % History.Snapshots.Num();
+		History.Num = FMath::Min(History.Num + 1, History.Snapshots.Num());
+	}
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(AShooterCharacter* Character)
+{
+	if (!Character || Characters.Contains(Character))
+		return;
+
+	// Reuse the slot of a destroyed character when there is one
+	int32 Index = Characters.IndexOfByPredicate([](const TWeakObjectPtr<AShooterCharacter>& Other) { return !Other.IsValid(); });
+	if (Index == INDEX_NONE)
+	{
+		Index = Characters.Add(nullptr);
+		Histories.AddDefaulted();
+	}
+
+	Characters[Index] = Character;
+	FHitboxHistory& History = Histories[Index];
+	History.Snapshots.SetNum(HistoryCapacity);
+	History.Head = 0;
+	History.Num = 0;
+}
+
+void ULagCompensationSubsystem::UnregisterCharacter(AShooterCharacter* Character)
+{
+	const int32 Index = Characters.IndexOfByKey(Character);
+	if (Index == INDEX_NONE)
+		return;
+
+	// Keep the slot and its storage around for the next character
+	Characters[Index] = nullptr;
+	Histories[Index].Num = 0;
+}
+
+void ULagCompensationSubsystem::RecordSnapshot(const AShooterCharacter* Character, double Time, FHitboxSnapshot& OutSnapshot) const
+{
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	OutSnapshot.Time = Time;
+	OutSnapshot.CapsuleCenter = Capsule->GetComponentLocation();
+	OutSnapshot.CapsuleRotation = Capsule->GetComponentQuat();
+	OutSnapshot.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	OutSnapshot.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	for (int32 Bone = 0; Bone < NumHitboxBones; Bone++)
+		OutSnapshot.BoneLocations[Bone] = Mesh ? Mesh->GetBoneLocation(GetHitboxBoneName(Bone)) : OutSnapshot.CapsuleCenter;
+}
+
+bool ULagCompensationSubsystem::GetSnapshotAtTime(const FHitboxHistory& History, double Time, FHitboxSnapshot& OutSnapshot) const
+{
+	if (History.Num == 0)
+		return false;
+
+	const int32 Capacity = History.Snapshots.Num();
+	const int32 Newest = (History.Head - 1 + Capacity) % Capacity;
+
+	// Walk from the newest snapshot back until one is older than Time
+	const FHitboxSnapshot* Later = &History.Snapshots[Newest];
+	if (Time >= Later->Time)
+	{
+		OutSnapshot = *Later;
+		return true;
+	}
+
+	for (int32 Step = 1; Step < History.Num; Step++)
+	{
+		const FHitboxSnapshot* Earlier = &History.Snapshots[(Newest - Step + Capacity) % Capacity];
+		if (Earlier->Time <= Time)
+		{
+			const float Alpha = static_cast<float>((Time - Earlier->Time) / FMath::Max(Later->Time - Earlier->Time, KINDA_SMALL_NUMBER));
+
+			OutSnapshot.Time = Time;
+			OutSnapshot.CapsuleCenter = FMath::Lerp(Earlier->CapsuleCenter, Later->CapsuleCenter, Alpha);
+			OutSnapshot.CapsuleRotation = FQuat::Slerp(Earlier->CapsuleRotation, Later->CapsuleRotation, Alpha);
+			OutSnapshot.CapsuleRadius = FMath::Lerp(Earlier->CapsuleRadius, Later->CapsuleRadius, Alpha);
+			OutSnapshot.CapsuleHalfHeight = FMath::Lerp(Earlier->CapsuleHalfHeight, Later->CapsuleHalfHeight, Alpha);
+			for (int32 Bone = 0; Bone < NumHitboxBones; Bone++)
+				OutSnapshot.BoneLocations[Bone] = FMath::Lerp(Earlier->BoneLocations[Bone], Later->BoneLocations[Bone], Alpha);
+
+			return true;
+		}
+
+		Later = Earlier;
+	}
+
+	// Older than the whole history, use the oldest snapshot
+	OutSnapshot = *Later;
+	return true;
+}
+
+bool ULagCompensationSubsystem::TraceRewound(const FVector& Start, const FVector& End, double ShotTime, const AShooterCharacter* Shooter, FRewoundHit& OutHit) const
+{
+	OutHit = FRewoundHit();
+	double ClosestDistance = TNumericLimits<double>::Max();
+	FHitboxSnapshot Snapshot;
+
+	for (int32 Index = 0; Index < Characters.Num(); Index++)
+	{
+		AShooterCharacter* Character = Characters[Index].Get();
+		if (!Character || Character == Shooter || !GetSnapshotAtTime(Histories[Index], ShotTime, Snapshot))
+			continue;
+
+		// Broad phase against the capsule axis
+		const FVector CapsuleUp = Snapshot.CapsuleRotation.GetUpVector() * FMath::Max(Snapshot.CapsuleHalfHeight - Snapshot.CapsuleRadius, 0.0f);
+		FVector PointOnRay;
+		FVector PointOnCapsule;
+		FMath::SegmentDistToSegmentSafe(Start, End, Snapshot.CapsuleCenter - CapsuleUp, Snapshot.CapsuleCenter + CapsuleUp, PointOnRay, PointOnCapsule);
+		if (FVector::DistSquared(PointOnRay, PointOnCapsule) > FMath::Square(Snapshot.CapsuleRadius))
+			continue;
+
+		const double Distance = FVector::Dist(Start, PointOnRay);
+		if (Distance >= ClosestDistance)
+			continue;
+
+		ClosestDistance = Distance;
+		OutHit.Character = Character;
+		OutHit.Location = PointOnRay;
+		OutHit.BoneName = NAME_None;
+
+		// Narrow phase against the bone spheres
+		for (int32 Bone = 0; Bone < NumHitboxBones; Bone++)
+		{
+			if (FMath::PointDistToSegment(Snapshot.BoneLocations[Bone], Start, End) <= HitboxBoneRadii[Bone])
+			{
+				OutHit.BoneName = GetHitboxBoneName(Bone);
+				break;
+			}
+		}
+	}
+
+	return OutHit.Character != nullptr;
+}
+
+bool ULagCompensationSubsystem::ConfirmShot(AShooterCharacter* Shooter, const FVector& Start, const FVector& Direction, double ShotTime)
+{
+	// Never trust a time from the future or beyond the rewind window
+	const double Now = GetWorld()->GetTimeSeconds();
+	ShotTime = FMath::Clamp(ShotTime, Now - MaxRewindTime, Now);
+
+	// Nor an origin away from the shooter, which could shoot from behind cover
+	FVector Origin;
+	if (!ClampShotOrigin(Shooter, Start, ShotTime, Origin))
+		return false;
+
+	FRewoundHit Hit;
+	if (!TraceRewound(Origin, Origin + Direction.GetSafeNormal() * ShotRange, ShotTime, Shooter, Hit))
+		return false;
+
+	// Rewound hitboxes ignore the level, check nothing solid stood between. Characters only count through their hitboxes
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ConfirmShot), false);
+	for (const TWeakObjectPtr<AShooterCharacter>& Character : Characters)
+	{
+		if (Character.IsValid())
+			QueryParams.AddIgnoredActor(Character.Get());
+	}
+	if (GetWorld()->LineTraceTestByChannel(Origin, Hit.Location, ECollisionChannel::ECC_Visibility, QueryParams))
+		return false;
+
+	UE_LOG(LogShooter, Verbose, TEXT("%s hit %s (%s) rewound %.0f ms"), *GetNameSafe(Shooter), *GetNameSafe(Hit.Character), *Hit.BoneName.ToString(), (Now - ShotTime) * 1000.0);
+	OnHitConfirmed.Broadcast(Shooter, Hit);
+	return true;
+}
+
+bool ULagCompensationSubsystem::ClampShotOrigin(const AShooterCharacter* Shooter, const FVector& Origin, double ShotTime, FVector& OutOrigin) const
+{
+	const int32 Index = Characters.IndexOfByKey(Shooter);
+	FHitboxSnapshot Snapshot;
+	if (Index == INDEX_NONE || !GetSnapshotAtTime(Histories[Index], ShotTime, Snapshot))
+		return false;
+
+	OutOrigin = Snapshot.CapsuleCenter + (Origin - Snapshot.CapsuleCenter).GetClampedToMaxSize(MaxShotOriginOffset);
+	return true;
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class AShooterCharacter;
+
+// Bones tracked as sphere hitboxes in every snapshot
+static constexpr int32 NumHitboxBones = 3;
+
+// Hitboxes of one character at one server time
+struct FHitboxSnapshot
+{
+	double Time = 0.0;
+
+	FVector CapsuleCenter = FVector::ZeroVector;
+	FQuat CapsuleRotation = FQuat::Identity;
+	float CapsuleRadius = 0.0f;
+	float CapsuleHalfHeight = 0.0f;
+
+	FVector BoneLocations[NumHitboxBones];
+};
+
+// Fixed size ring buffer of snapshots, allocated once when the character registers
+struct FHitboxHistory
+{
+	TArray<FHitboxSnapshot> Snapshots;
+
+	// Slot the next snapshot is written to
+	int32 Head = 0;
+
+	// Number of valid snapshots
+	int32 Num = 0;
+};
+
+// Result of a trace against rewound hitboxes
+struct FRewoundHit
+{
+	AShooterCharacter* Character = nullptr;
+	FVector Location = FVector::ZeroVector;
+
+	// Bone hitbox which was hit, NAME_None when only the capsule was hit
+	FName BoneName = NAME_None;
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnRewoundHitConfirmed, AShooterCharacter* /*Shooter*/, const FRewoundHit& /*Hit*/);
+
+/**
+ * Server side lag compensation. Records a compact hitbox snapshot of every character each
+ * server tick and validates shots against the hitboxes as they were at the client's shot time
+ */
+UCLASS()
+class SHOOTER_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterCharacter(AShooterCharacter* Character);
+	void UnregisterCharacter(AShooterCharacter* Character);
+
+	// Traces Start to End against every character except Shooter, rewound to ShotTime
+	bool TraceRewound(const FVector& Start, const FVector& End, double ShotTime, const AShooterCharacter* Shooter, FRewoundHit& OutHit) const;
+
+	// Validates a shot fired by Shooter and broadcasts OnHitConfirmed when it hits someone
+	bool ConfirmShot(AShooterCharacter* Shooter, const FVector& Start, const FVector& Direction, double ShotTime);
+
+	// Moves a client supplied shot origin to within reach of where Shooter stood at ShotTime, false when Shooter has no history
+	bool ClampShotOrigin(const AShooterCharacter* Shooter, const FVector& Origin, double ShotTime, FVector& OutOrigin) const;
+
+	// Furthest a shot can be rewound, older shots are clamped to this
+	FORCEINLINE double GetMaxRewindTime() const { return MaxRewindTime; }
+
+	FOnRewoundHitConfirmed OnHitConfirmed;
+
+private:
+	void RecordSnapshot(const AShooterCharacter* Character, double Time, FHitboxSnapshot& OutSnapshot) const;
+
+	// Interpolates History at Time, returns false when it holds no snapshot
+	bool GetSnapshotAtTime(const FHitboxHistory& History, double Time, FHitboxSnapshot& OutSnapshot) const;
+
+	// Snapshots kept per character
+	int32 HistoryCapacity = 64;
+
+	double MaxRewindTime = 0.5;
+
+	// Length of the validation trace
+	float ShotRange = 50000.0f;
+
+	// Furthest a shot origin may be from the shooter's rewound capsule center, covers the muzzle in any pose
+	float MaxShotOriginOffset = 150.0f;
+
+	// Registered characters and their history, both arrays share the same index
+	TArray<TWeakObjectPtr<AShooterCharacter>> Characters;
+	TArray<FHitboxHistory> Histories;
+};
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PackedShot.h"
+#include "UObject/CoreNet.h"
+
+// Sent in front of the parameters of every unreliable RPC: about 40 bits of bunch header (channel
+// index, flags and the bunch size), the content block header, and the packed field handle and
+// payload size. Packet headers are shared with everything else in the packet and left out
+static constexpr int32 RpcHeaderBits = 64;
+
+bool FPackedShot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Origin.NetSerialize(Ar, Map, bOutSuccess);
+	Ar.SerializeBits(&Direction, 32);
+
+	// Time deltas and distances are usually small, pack them as variable length ints
+	uint32 PackedDeltaTime = DeltaTimeMs;
+	uint32 PackedHitDistance = HitDistance;
+	Ar.SerializeIntPacked(PackedDeltaTime);
+	Ar.SerializeIntPacked(PackedHitDistance);
+
+	if (Ar.IsLoading())
+	{
+		DeltaTimeMs = static_cast<uint16>(FMath::Min<uint32>(PackedDeltaTime, MAX_uint16));
+		HitDistance = static_cast<uint16>(FMath::Min<uint32>(PackedHitDistance, MAX_uint16));
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FPackedShot::Pack(const FVector& InOrigin, const FVector& BeamEnd, bool bHit, double ShotTime, double BatchTime)
+{
+	const FVector OriginToEnd = BeamEnd - InOrigin;
+
+	Origin = InOrigin;
+	Direction = EncodeOctahedral(OriginToEnd.GetSafeNormal());
+	DeltaTimeMs = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(static_cast<float>((ShotTime - BatchTime) * 1000.0)), 0, static_cast<int32>(MAX_uint16)));
+	HitDistance = bHit ? static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(static_cast<float>(OriginToEnd.Size())), 1, static_cast<int32>(MAX_uint16))) : 0;
+}
+
+FVector FPackedShot::GetDirection() const
+{
+	return DecodeOctahedral(Direction);
+}
+
+FVector FPackedShot::GetBeamEnd() const
+{
+	return Origin + GetDirection() * HitDistance;
+}
+
+uint32 FPackedShot::EncodeOctahedral(const FVector& Direction)
+{
+	const float L1Norm = FMath::Abs(Direction.X) + FMath::Abs(Direction.Y) + FMath::Abs(Direction.Z);
+	if (L1Norm <= KINDA_SMALL_NUMBER)
+		return EncodeOctahedral(FVector::ForwardVector);
+
+	float X = Direction.X / L1Norm;
+	float Y = Direction.Y / L1Norm;
+
+	// Fold the lower hemisphere over the diagonals
+	if (Direction.Z < 0.0f)
+	{
+		const float FoldedX = (1.0f - FMath::Abs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+		const float FoldedY = (1.0f - FMath::Abs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+		X = FoldedX;
+		Y = FoldedY;
+	}
+
+	const uint32 QuantizedX = static_cast<uint32>(FMath::RoundToInt((X * 0.5f + 0.5f) * MAX_uint16));
+	const uint32 QuantizedY = static_cast<uint32>(FMath::RoundToInt((Y * 0.5f + 0.5f) * MAX_uint16));
+	return (QuantizedX << 16) | QuantizedY;
+}
+
+FVector FPackedShot::DecodeOctahedral(uint32 Encoded)
+{
+	const float X = ((Encoded >> 16) / static_cast<float>(MAX_uint16)) * 2.0f - 1.0f;
+	const float Y = ((Encoded & MAX_uint16) / static_cast<float>(MAX_uint16)) * 2.0f - 1.0f;
+
+	FVector Direction(X, Y, 1.0f - FMath::Abs(X) - FMath::Abs(Y));
+
+	// Unfold the lower hemisphere
+	const float Fold = FMath::Max(-static_cast<float>(Direction.Z), 0.0f);
+	Direction.X += Direction.X >= 0.0f ? -Fold : Fold;
+	Direction.Y += Direction.Y >= 0.0f ? -Fold : Fold;
+
+	return Direction.GetSafeNormal();
+}
+
+void FShotBandwidthStats::CountBatch(double BatchTime, const TArray<FPackedShot>& Batch)
+{
+	bool bSuccess = true;
+
+	// Payload of the batch RPC: batch time, array count and the packed shots
+	FNetBitWriter PackedWriter(nullptr, 0);
+	PackedWriter << BatchTime;
+	uint32 NumShots = Batch.Num();
+	PackedWriter.SerializeIntPacked(NumShots);
+	for (FPackedShot Shot : Batch)
+		Shot.NetSerialize(PackedWriter, nullptr, bSuccess);
+
+	// Payload of one naive RPC per shot: full precision time, quantized start and normal
+	FNetBitWriter NaiveWriter(nullptr, 0);
+	for (const FPackedShot& Shot : Batch)
+	{
+		FVector_NetQuantize Start = Shot.Origin;
+		FVector_NetQuantizeNormal Direction = Shot.GetDirection();
+		double ShotTime = Shot.GetShotTime(BatchTime);
+		Start.NetSerialize(NaiveWriter, nullptr, bSuccess);
+		Direction.NetSerialize(NaiveWriter, nullptr, bSuccess);
+		NaiveWriter << ShotTime;
+	}
+
+	if (PackedRpcs == 0)
+		FirstBatchTime = BatchTime;
+	LastBatchTime = BatchTime;
+
+	Shots += Batch.Num();
+	PackedRpcs++;
+	PackedBits += PackedWriter.GetNumBits() + RpcHeaderBits;
+	NaiveRpcs += Batch.Num();
+	NaiveBits += NaiveWriter.GetNumBits() + static_cast<int64>(RpcHeaderBits) * Batch.Num();
+}
+
+double FShotBandwidthStats::GetPackedBytesPerSecond() const
+{
+	const double Seconds = LastBatchTime - FirstBatchTime;
+	return Seconds > 0.0 ? PackedBits / 8.0 / Seconds : 0.0;
+}
+
+double FShotBandwidthStats::GetNaiveBytesPerSecond() const
+{
+	const double Seconds = LastBatchTime - FirstBatchTime;
+	return Seconds > 0.0 ? NaiveBits / 8.0 / Seconds : 0.0;
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "PackedShot.generated.h"
+
+/**
+ * One shot as sent over the network. Shots of a frame travel together in one RPC
+ * and store their time relative to the time of the batch
+ */
+USTRUCT()
+struct FPackedShot
+{
+	GENERATED_BODY()
+
+	// Muzzle location, quantized to whole units
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	// Octahedral encoded direction, 16 bits per axis
+	UPROPERTY()
+	uint32 Direction = 0;
+
+	// Milliseconds after the batch time
+	UPROPERTY()
+	uint16 DeltaTimeMs = 0;
+
+	// Distance from the origin to the impact, 0 when nothing was hit
+	UPROPERTY()
+	uint16 HitDistance = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	// Fills the shot from a world space muzzle origin and beam end
+	void Pack(const FVector& InOrigin, const FVector& BeamEnd, bool bHit, double ShotTime, double BatchTime);
+
+	FVector GetDirection() const;
+	FVector GetBeamEnd() const;
+	FORCEINLINE double GetShotTime(double BatchTime) const { return BatchTime + DeltaTimeMs / 1000.0; }
+
+	// Maps a unit vector onto two 16 bit octahedron coordinates
+	static uint32 EncodeOctahedral(const FVector& Direction);
+	static FVector DecodeOctahedral(uint32 Encoded);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPackedShot> : public TStructOpsTypeTraitsBase2<FPackedShot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// Bits sent by one shooter, packed batches against the per-shot RPC they replace. Bit counts
+// include the bunch and RPC headers in front of every RPC's parameters
+struct FShotBandwidthStats
+{
+	int32 Shots = 0;
+	int32 PackedRpcs = 0;
+	int64 PackedBits = 0;
+	int32 NaiveRpcs = 0;
+	int64 NaiveBits = 0;
+
+	// Batch times of the first and last batch counted
+	double FirstBatchTime = 0.0;
+	double LastBatchTime = 0.0;
+
+	// Adds one batch RPC and the per-shot RPCs it replaces
+	void CountBatch(double BatchTime, const TArray<FPackedShot>& Batch);
+
+	// Bytes per second between the first and the last batch
+	double GetPackedBytesPerSecond() const;
+	double GetNaiveBytesPerSecond() const;
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PickupWidget.h"
+#include "Item.h"
+#include "Kismet/GameplayStatics.h"
+
+void UPickupWidget::BindItem(AItem* Item)
+{
+	if (Item == BoundItem)
+	{
+		if (BoundItem && BoundItem->GetItemCount() != BoundItemCount)
+		{
+			BoundItemCount = BoundItem->GetItemCount();
+			OnItemBound();
+		}
+		return;
+	}
+
+	BoundItem = Item;
+
+	if (BoundItem)
+	{
+		BoundItemCount = BoundItem->GetItemCount();
+
+		// Anchor the bottom center of the prompt on the item
+		SetAlignmentInViewport(FVector2D(0.5f, 1.0f));
+		SetVisibility(ESlateVisibility::HitTestInvisible);
+		OnItemBound();
+	}
+	else
+	{
+		SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+void UPickupWidget::UpdatePosition(APlayerController* PlayerController)
+{
+	if (!BoundItem || !PlayerController)
+		return;
+
+	FVector2D ScreenPosition;
+	if (UGameplayStatics::ProjectWorldToScreen(PlayerController, BoundItem->GetActorLocation() + WorldOffset, ScreenPosition, true))
+		SetPositionInViewport(ScreenPosition);
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "PickupWidget.generated.h"
+
+class AItem;
+
+/**
+ * Screen space pickup prompt, one per local player. It is bound to whichever item
+ * the player is looking at and reads name, count and stars from that item
+ */
+UCLASS()
+class SHOOTER_API UPickupWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	// Shows the prompt for Item, hides it when Item is null. Called again with the bound item, it refreshes the prompt once the count changed
+	void BindItem(AItem* Item);
+
+	// Keeps the prompt anchored above the bound item
+	void UpdatePosition(APlayerController* PlayerController);
+
+	FORCEINLINE AItem* GetBoundItem() const { return BoundItem; }
+
+protected:
+	// Called after a new item was bound, or the bound item's count changed, so the blueprint can refresh its text and stars
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pickup")
+	void OnItemBound();
+
+private:
+	// The item this prompt currently describes
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pickup", meta = (AllowPrivateAccess = "true"))
+	AItem* BoundItem;
+
+	// Count of BoundItem the prompt last showed, the count replicates without a notify
+	int32 BoundItemCount = 0;
+
+	// Offset from the item's origin where the prompt is anchored
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pickup", meta = (AllowPrivateAccess = "true"))
+	FVector WorldOffset = FVector(0.0f, 0.0f, 75.0f);
+};
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProjectileSubsystem.h"
+#include "Shooter.h"
+#include "VFXPoolSubsystem.h"
+#include "Engine/World.h"
+#include "Math/VectorRegister.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Step"), STAT_ProjectileStep, STATGROUP_Shooter);
+DECLARE_CYCLE_STAT(TEXT("Projectile Sweeps"), STAT_ProjectileSweeps, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Projectiles"), STAT_LiveProjectiles, STATGROUP_Shooter);
+
+void UProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SweepDelegate.BindUObject(this, &UProjectileSubsystem::OnSweepDone);
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+uint32 UProjectileSubsystem::LaunchProjectile(const FVector& Location, const FVector& Velocity, const FProjectileParams& Params, AActor* Instigator)
+{
+	const uint32 Id = NextProjectileId++;
+	IdToIndex.Add(Id, Ids.Num());
+
+	PositionX.Add(Location.X);
+	PositionY.Add(Location.Y);
+	PositionZ.Add(Location.Z);
+	VelocityX.Add(Velocity.X);
+	VelocityY.Add(Velocity.Y);
+	VelocityZ.Add(Velocity.Z);
+	GravityScales.Add(Params.GravityScale);
+	LifeTimes.Add(Params.LifeTime);
+	Radii.Add(Params.Radius);
+	Ids.Add(Id);
+	Instigators.Add(Instigator);
+	ImpactParticles.Add(Params.ImpactParticles);
+
+	return Id;
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Ids.Num() == 0)
+		return;
+
+	SET_DWORD_STAT(STAT_LiveProjectiles, Ids.Num());
+	Stats.Ticks++;
+
+	StepProjectiles(DeltaTime);
+	IssueSweeps();
+}
+
+void UProjectileSubsystem::StepProjectiles(float DeltaTime)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ProjectileStep);
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	// Projectiles which expired last tick were swept along their final segment, that sweep has landed by now
+	for (int32 Index = Ids.Num() - 1; Index >= 0; Index--)
+	{
+		if (LifeTimes[Index] <= 0.0f)
+			RemoveAtSwap(Index);
+	}
+
+	const int32 Num = Ids.Num();
+	StartX.SetNumUninitialized(Num, false);
+	StartY.SetNumUninitialized(Num, false);
+	StartZ.SetNumUninitialized(Num, false);
+	FMemory::Memcpy(StartX.GetData(), PositionX.GetData(), Num * sizeof(float));
+	FMemory::Memcpy(StartY.GetData(), PositionY.GetData(), Num * sizeof(float));
+	FMemory::Memcpy(StartZ.GetData(), PositionZ.GetData(), Num * sizeof(float));
+
+	const float GravityZ = GetWorld()->GetGravityZ();
+
+	// Four projectiles per iteration
+	const VectorRegister4Float VecDeltaTime = VectorSetFloat1(DeltaTime);
+	const VectorRegister4Float VecGravityDelta = VectorSetFloat1(GravityZ * DeltaTime);
+
+	int32 Index = 0;
+	for (; Index + 4 <= Num; Index += 4)
+	{
+		const VectorRegister4Float VelX = VectorLoad(&VelocityX[Index]);
+		const VectorRegister4Float VelY = VectorLoad(&VelocityY[Index]);
+		const VectorRegister4Float VelZ = VectorMultiplyAdd(VectorLoad(&GravityScales[Index]), VecGravityDelta, VectorLoad(&VelocityZ[Index]));
+
+		VectorStore(VelZ, &VelocityZ[Index]);
+		VectorStore(VectorMultiplyAdd(VelX, VecDeltaTime, VectorLoad(&PositionX[Index])), &PositionX[Index]);
+		VectorStore(VectorMultiplyAdd(VelY, VecDeltaTime, VectorLoad(&PositionY[Index])), &PositionY[Index]);
+		VectorStore(VectorMultiplyAdd(VelZ, VecDeltaTime, VectorLoad(&PositionZ[Index])), &PositionZ[Index]);
+		VectorStore(VectorSubtract(VectorLoad(&LifeTimes[Index]), VecDeltaTime), &LifeTimes[Index]);
+	}
+
+	// Remainder
+	for (; Index < Num; Index++)
+	{
+		VelocityZ[Index] += GravityScales[Index] * GravityZ * DeltaTime;
+		PositionX[Index] += VelocityX[Index] * DeltaTime;
+		PositionY[Index] += VelocityY[Index] * DeltaTime;
+		PositionZ[Index] += VelocityZ[Index] * DeltaTime;
+		LifeTimes[Index] -= DeltaTime;
+	}
+
+	Stats.StepCycles += FPlatformTime::Cycles() - StartCycles;
+}
+
+void UProjectileSubsystem::IssueSweeps()
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_ProjectileSweeps);
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	UWorld* World = GetWorld();
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false);
+
+	for (int32 Index = 0; Index < Ids.Num(); Index++)
+	{
+		const FVector Start(StartX[Index], StartY[Index], StartZ[Index]);
+		const FVector End(PositionX[Index], PositionY[Index], PositionZ[Index]);
+
+		// The instigator never hits itself
+		QueryParams.ClearIgnoredActors();
+		if (AActor* Instigator = Instigators[Index].Get())
+			QueryParams.AddIgnoredActor(Instigator);
+
+		const FCollisionShape Shape = Radii[Index] > 0.0f ? FCollisionShape::MakeSphere(Radii[Index]) : FCollisionShape();
+		World->AsyncSweepByChannel(EAsyncTraceType::Single, Start, End, FQuat::Identity, ECollisionChannel::ECC_Visibility, Shape,
+			QueryParams, FCollisionResponseParams::DefaultResponseParam, &SweepDelegate, Ids[Index]);
+	}
+
+	Stats.SweepsIssued += Ids.Num();
+	Stats.SweepCycles += FPlatformTime::Cycles() - StartCycles;
+}
+
+void UProjectileSubsystem::OnSweepDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceDatum.OutHits.Num() == 0 || !TraceDatum.OutHits[0].bBlockingHit)
+		return;
+
+	// Expired, or an earlier sweep of the same projectile already hit
+	const int32* Index = IdToIndex.Find(TraceDatum.UserData);
+	if (!Index)
+		return;
+
+	FProjectileHit ProjectileHit;
+	ProjectileHit.ProjectileId = TraceDatum.UserData;
+	ProjectileHit.Instigator = Instigators[*Index];
+	ProjectileHit.Hit = TraceDatum.OutHits[0];
+
+	if (UParticleSystem* Impact = ImpactParticles[*Index])
+	{
+		if (UVFXPoolSubsystem* VFXPool = GetWorld()->GetSubsystem<UVFXPoolSubsystem>())
+			VFXPool->SpawnEmitter(Impact, FVector(ProjectileHit.Hit.ImpactPoint));
+	}
+
+	RemoveAtSwap(*Index);
+	Stats.Hits++;
+
+	OnProjectileHit.Broadcast(ProjectileHit);
+}
+
+void UProjectileSubsystem::RemoveAtSwap(int32 Index)
+{
+	IdToIndex.Remove(Ids[Index]);
+
+	const int32 LastIndex = Ids.Num() - 1;
+	if (Index != LastIndex)
+		IdToIndex.Add(Ids[LastIndex], Index);
+
+	PositionX.RemoveAtSwap(Index, 1, false);
+	PositionY.RemoveAtSwap(Index, 1, false);
+	PositionZ.RemoveAtSwap(Index, 1, false);
+	VelocityX.RemoveAtSwap(Index, 1, false);
+	VelocityY.RemoveAtSwap(Index, 1, false);
+	VelocityZ.RemoveAtSwap(Index, 1, false);
+	GravityScales.RemoveAtSwap(Index, 1, false);
+	LifeTimes.RemoveAtSwap(Index, 1, false);
+	Radii.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	ImpactParticles.RemoveAtSwap(Index, 1, false);
+
+	// Start positions are only read right after the step, keep them in line anyway
+	if (StartX.IsValidIndex(LastIndex))
+	{
+		StartX.RemoveAtSwap(Index, 1, false);
+		StartY.RemoveAtSwap(Index, 1, false);
+		StartZ.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GProjectileSpawnCommand(
+	TEXT("Shooter.Projectiles.Spawn"),
+	TEXT("Launches N projectiles in random directions from 2m above the world origin, for measuring simulation cost. Default 10000"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UProjectileSubsystem* Projectiles = World ? World->GetSubsystem<UProjectileSubsystem>() : nullptr;
+		if (!Projectiles)
+			return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		FRandomStream Random(0);
+		FProjectileParams Params;
+		Params.GravityScale = 0.25f;
+		Params.LifeTime = 30.0f;
+
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			FVector Direction = Random.GetUnitVector();
+			Direction.Z = FMath::Abs(Direction.Z);
+			Projectiles->LaunchProjectile(FVector(0.0f, 0.0f, 200.0f), Direction * Random.FRandRange(500.0f, 3000.0f), Params, nullptr);
+		}
+
+		Projectiles->ResetStats();
+	}));
+
+static FAutoConsoleCommandWithWorld GProjectileStatsCommand(
+	TEXT("Shooter.Projectiles.Stats"),
+	TEXT("Prints the average projectile step and sweep cost per tick since the last call, then resets it"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UProjectileSubsystem* Projectiles = World ? World->GetSubsystem<UProjectileSubsystem>() : nullptr;
+		if (!Projectiles)
+			return;
+
+		const FProjectileStats& Stats = Projectiles->GetStats();
+		const int32 Ticks = FMath::Max(Stats.Ticks, 1);
+		UE_LOG(LogShooter, Display, TEXT("Projectiles: %d live, %d ticks, step %.3f ms, sweeps %.3f ms per tick, %.0f sweeps per tick, %d hits"),
+			Projectiles->GetNumProjectiles(), Stats.Ticks,
+			FPlatformTime::ToMilliseconds64(Stats.StepCycles) / Ticks, FPlatformTime::ToMilliseconds64(Stats.SweepCycles) / Ticks,
+			static_cast<double>(Stats.SweepsIssued) / Ticks, Stats.Hits);
+		Projectiles->ResetStats();
+	}));
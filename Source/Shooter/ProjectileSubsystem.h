@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "ProjectileSubsystem.generated.h"
+
+class UParticleSystem;
+
+// How a projectile flies, given when launching it
+struct FProjectileParams
+{
+	// Sweep radius, 0 for a line trace
+	float Radius = 0.0f;
+
+	// Multiplier on the world gravity, 0 flies straight
+	float GravityScale = 0.0f;
+
+	// Seconds before the projectile expires without hitting anything
+	float LifeTime = 5.0f;
+
+	// Spawned through the VFX pool where the projectile hits
+	UParticleSystem* ImpactParticles = nullptr;
+};
+
+// Passed to OnProjectileHit
+struct FProjectileHit
+{
+	uint32 ProjectileId;
+	TWeakObjectPtr<AActor> Instigator;
+	FHitResult Hit;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnProjectileHit, const FProjectileHit&);
+
+// Simulation cost accumulated since the last reset
+struct FProjectileStats
+{
+	int32 Ticks = 0;
+	uint64 StepCycles = 0;
+	uint64 SweepCycles = 0;
+	int64 SweepsIssued = 0;
+	int32 Hits = 0;
+};
+
+/**
+ * Simulates every projectile of the world without an actor per projectile. State lives in
+ * structure-of-arrays form, integration runs four projectiles per vector instruction, and the
+ * sweeps of each tick are issued as one batch of async traces whose results land next frame
+ */
+UCLASS()
+class SHOOTER_API UProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts a projectile at Location, returns its id
+	uint32 LaunchProjectile(const FVector& Location, const FVector& Velocity, const FProjectileParams& Params, AActor* Instigator);
+
+	FORCEINLINE int32 GetNumProjectiles() const { return Ids.Num(); }
+
+	FORCEINLINE const FProjectileStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = FProjectileStats(); }
+
+	// Broadcast for every projectile which hit something, before it is removed
+	FOnProjectileHit OnProjectileHit;
+
+private:
+	// Advances positions, velocities and lifetimes of all projectiles
+	void StepProjectiles(float DeltaTime);
+
+	// Issues one async sweep per projectile along its movement this tick
+	void IssueSweeps();
+
+	void OnSweepDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	// Swaps the last projectile into Index
+	void RemoveAtSwap(int32 Index);
+
+	// Per projectile state, all arrays share the same index
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> GravityScales;
+	TArray<float> LifeTimes;
+	TArray<float> Radii;
+	TArray<uint32> Ids;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+
+	UPROPERTY()
+	TArray<UParticleSystem*> ImpactParticles;
+
+	// Positions at the start of the current step, the sweeps run from here
+	TArray<float> StartX;
+	TArray<float> StartY;
+	TArray<float> StartZ;
+
+	// Index of each live projectile, sweep results only carry the id
+	TMap<uint32, int32> IdToIndex;
+
+	uint32 NextProjectileId = 1;
+
+	FTraceDelegate SweepDelegate;
+
+	FProjectileStats Stats;
+};
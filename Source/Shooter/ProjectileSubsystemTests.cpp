@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ProjectileSubsystem.h"
+#include "ShooterTestWorld.h"
+
+namespace
+{
+	// Projectiles in flight during the measurement
+	constexpr int32 ProjectileTestCount = 10000;
+
+	// Ticks measured, one second at 60 Hz
+	constexpr int32 ProjectileTestTicks = 60;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FProjectileSubsystemCostTest, "Shooter.Projectiles.TickCost", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FProjectileSubsystemCostTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+	UProjectileSubsystem* Projectiles = TestWorld.Get()->GetSubsystem<UProjectileSubsystem>();
+	if (!TestNotNull(TEXT("Projectile subsystem"), Projectiles))
+		return false;
+
+	// Spread over a grid in the empty world, long lived so every one of them is stepped and swept on each tick
+	FProjectileParams Params;
+	Params.Radius = 2.0f;
+	Params.GravityScale = 1.0f;
+	Params.LifeTime = 60.0f;
+	for (int32 Index = 0; Index < ProjectileTestCount; Index++)
+	{
+		const FVector Location((Index % 100) * 100.0f, (Index / 100) * 100.0f, 10000.0f);
+		Projectiles->LaunchProjectile(Location, FVector(5000.0f, 0.0f, 0.0f), Params, nullptr);
+	}
+
+	Projectiles->ResetStats();
+	for (int32 Tick = 0; Tick < ProjectileTestTicks; Tick++)
+		TestWorld.Tick(1.0f / 60.0f);
+
+	const FProjectileStats& Stats = Projectiles->GetStats();
+	const int32 Ticks = FMath::Max(Stats.Ticks, 1);
+	AddInfo(FString::Printf(TEXT("%d projectiles over %d ticks: step %.3f ms/tick, sweeps issued %.3f ms/tick, %.0f sweeps/tick"),
+		ProjectileTestCount, Stats.Ticks,
+		FPlatformTime::ToMilliseconds64(Stats.StepCycles) / Ticks, FPlatformTime::ToMilliseconds64(Stats.SweepCycles) / Ticks,
+		static_cast<double>(Stats.SweepsIssued) / Ticks));
+
+	TestEqual(TEXT("The subsystem ticks with the world"), Stats.Ticks, ProjectileTestTicks);
+	TestEqual(TEXT("Nothing expires or hits in the empty world"), Projectiles->GetNumProjectiles(), ProjectileTestCount);
+	TestEqual(TEXT("Every projectile is swept on every tick"), Stats.SweepsIssued, static_cast<int64>(ProjectileTestCount) * ProjectileTestTicks);
+	return true;
+}
+
+#endif
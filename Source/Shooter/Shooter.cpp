@@ -4,3 +4,7 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Shooter, "Shooter" );
+
+DEFINE_LOG_CATEGORY(LogShooter);
+
+UE_TRACE_CHANNEL_DEFINE(ShooterChannel);
@@ -3,4 +3,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogShooter, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Shooter"), STATGROUP_Shooter, STATCAT_Advanced);
+
+// Insights channel for gameplay hot paths, enable with -trace=cpu,shooter
+UE_TRACE_CHANNEL_EXTERN(ShooterChannel, SHOOTER_API);
+
+// Times the enclosing scope for stat shooter and as a CPU event on the Shooter trace channel
+#define SHOOTER_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, ShooterChannel)
 
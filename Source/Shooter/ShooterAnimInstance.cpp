@@ -1,43 +1,112 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "ShooterAnimInstance.h"
+#include "Shooter.h"
 #include "ShooterCharacter.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "GameFramework/CharacterMovementComponent.h"  
 
-void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
-{
-	if (ShooterCharacter == nullptr) 
-		ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
+DECLARE_CYCLE_STAT(TEXT("Anim NativeUpdate"), STAT_AnimNativeUpdate, STATGROUP_Shooter);
+DECLARE_CYCLE_STAT(TEXT("Anim NativeThreadSafeUpdate"), STAT_AnimNativeThreadSafeUpdate, STATGROUP_Shooter);
 
-	if (ShooterCharacter)
-	{
-		// Get the lateral speed of the character from velocity
-		FVector Velocity = ShooterCharacter->GetVelocity();
-		Velocity.Z = 0; 
-		Speed = Velocity.Size();
+// Added to from the game thread and the animation workers, see ConsumeCycles
+static volatile int64 GAnimUpdateCycles = 0;
+static volatile int64 GAnimThreadSafeUpdateCycles = 0;
+static volatile int64 GAnimGraphGameThreadCycles = 0;
+static volatile int64 GAnimGraphWorkerCycles = 0;
 
-		// Is the character in the air?
-		bIsInAir = ShooterCharacter->GetCharacterMovement()->IsFalling();
-		
-		// Is the character accelerating?
-		if (ShooterCharacter->GetCharacterMovement()->GetCurrentAcceleration().Size() > 0.0f)
-			bIsAccelerating = true;
-		else
-			bIsAccelerating = false;
+// Adds the cycles since StartCycles to the graph counter of the calling thread
+static void AddGraphCycles(uint32 StartCycles)
+{
+	volatile int64* Counter = IsInGameThread() ? &GAnimGraphGameThreadCycles : &GAnimGraphWorkerCycles;
+	FPlatformAtomics::InterlockedAdd(Counter, FPlatformTime::Cycles() - StartCycles);
+}
 
-		FRotator AimRotation = ShooterCharacter->GetBaseAimRotation();
-		FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(ShooterCharacter->GetVelocity());
-		MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation).Yaw;
+void FShooterAnimInstanceProxy::UpdateAnimationNode_WithRoot(const FAnimationUpdateContext& InContext, FAnimNode_Base* InRootNode, FName InLayerName)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	Super::UpdateAnimationNode_WithRoot(InContext, InRootNode, InLayerName);
+	AddGraphCycles(StartCycles);
+}
 
-		if (ShooterCharacter->GetVelocity().Size() > 0.0f)
-			LastMovementOffsetYaw = MovementOffsetYaw;
+void FShooterAnimInstanceProxy::EvaluateAnimationNode_WithRoot(FPoseContext& Output, FAnimNode_Base* InRootNode)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	Super::EvaluateAnimationNode_WithRoot(Output, InRootNode);
+	AddGraphCycles(StartCycles);
+}
 
-		bAiming = ShooterCharacter->GetAiming();
-	}
+FShooterAnimCycles UShooterAnimInstance::ConsumeCycles()
+{
+	FShooterAnimCycles Cycles;
+	Cycles.Update = FPlatformAtomics::InterlockedExchange(&GAnimUpdateCycles, 0);
+	Cycles.ThreadSafeUpdate = FPlatformAtomics::InterlockedExchange(&GAnimThreadSafeUpdateCycles, 0);
+	Cycles.GraphGameThread = FPlatformAtomics::InterlockedExchange(&GAnimGraphGameThreadCycles, 0);
+	Cycles.GraphWorker = FPlatformAtomics::InterlockedExchange(&GAnimGraphWorkerCycles, 0);
+	return Cycles;
+}
+
+FAnimInstanceProxy* UShooterAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FShooterAnimInstanceProxy(this);
 }
 
 void UShooterAnimInstance::NativeInitializeAnimation()
 {
 	ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
 }
+
+void UShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_AnimNativeUpdate);
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	ON_SCOPE_EXIT { FPlatformAtomics::InterlockedAdd(&GAnimUpdateCycles, FPlatformTime::Cycles() - StartCycles); };
+
+	if (ShooterCharacter == nullptr) 
+		ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
+
+	Inputs.bValid = ShooterCharacter != nullptr;
+	if (!Inputs.bValid)
+		return;
+
+	// Everything the worker thread needs, nothing there may touch the character
+	const UCharacterMovementComponent* CharacterMovement = ShooterCharacter->GetCharacterMovement();
+	Inputs.Velocity = ShooterCharacter->GetVelocity();
+	Inputs.bIsFalling = CharacterMovement->IsFalling();
+	Inputs.bHasAcceleration = CharacterMovement->GetCurrentAcceleration().SizeSquared() > 0.0f;
+	Inputs.AimRotation = ShooterCharacter->GetBaseAimRotation();
+	Inputs.bAiming = ShooterCharacter->GetAiming();
+}
+
+void UShooterAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_AnimNativeThreadSafeUpdate);
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	ON_SCOPE_EXIT { FPlatformAtomics::InterlockedAdd(&GAnimThreadSafeUpdateCycles, FPlatformTime::Cycles() - StartCycles); };
+
+	if (!Inputs.bValid)
+		return;
+
+	// Get the lateral speed of the character from velocity
+	FVector LateralVelocity = Inputs.Velocity;
+	LateralVelocity.Z = 0; 
+	Speed = LateralVelocity.Size();
+
+	// Is the character in the air?
+	bIsInAir = Inputs.bIsFalling;
+
+	// Is the character accelerating?
+	bIsAccelerating = Inputs.bHasAcceleration;
+
+	FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Inputs.Velocity);
+	MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, Inputs.AimRotation).Yaw;
+
+	if (Inputs.Velocity.SizeSquared() > 0.0f)
+		LastMovementOffsetYaw = MovementOffsetYaw;
+
+	bAiming = Inputs.bAiming;
+}
@@ -4,8 +4,48 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "ShooterAnimInstance.generated.h"
 
+// Character state read on the game thread for the worker thread update
+struct FShooterAnimInputs
+{
+	bool bValid = false;
+	FVector Velocity = FVector::ZeroVector;
+	bool bIsFalling = false;
+	bool bHasAcceleration = false;
+	FRotator AimRotation = FRotator::ZeroRotator;
+	bool bAiming = false;
+};
+
+// Cycles every shooter anim instance spent in its native updates
+struct FShooterAnimCycles
+{
+	// NativeUpdateAnimation, on the game thread
+	uint64 Update = 0;
+
+	// NativeThreadSafeUpdateAnimation, on a worker thread unless parallel animation is off
+	uint64 ThreadSafeUpdate = 0;
+
+	// Anim graph update and pose evaluation, the work the animation budget throttles, by the thread it ran on
+	uint64 GraphGameThread = 0;
+	uint64 GraphWorker = 0;
+};
+
+// Times the anim graph update and evaluation of a shooter anim instance
+USTRUCT()
+struct FShooterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FShooterAnimInstanceProxy() {}
+	FShooterAnimInstanceProxy(UAnimInstance* InAnimInstance) : FAnimInstanceProxy(InAnimInstance) {}
+
+protected:
+	virtual void UpdateAnimationNode_WithRoot(const FAnimationUpdateContext& InContext, FAnimNode_Base* InRootNode, FName InLayerName) override;
+	virtual void EvaluateAnimationNode_WithRoot(FPoseContext& Output, FAnimNode_Base* InRootNode) override;
+};
+
 /**
  * 
  */
@@ -15,12 +55,24 @@ class SHOOTER_API UShooterAnimInstance : public UAnimInstance
 	GENERATED_BODY()
 
 public:
-	UFUNCTION(BlueprintCallable)
-	void UpdateAnimationProperties(float DeltaTime);
-
 	virtual void NativeInitializeAnimation() override;
 
+	// Snapshots the character on the game thread
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+	// Computes the animation properties from the snapshot, may run on a worker thread
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	// Cycles of all shooter anim instances since the last call
+	static FShooterAnimCycles ConsumeCycles();
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
 private:
+	// Written by NativeUpdateAnimation, read by NativeThreadSafeUpdateAnimation
+	FShooterAnimInputs Inputs;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = "true"))
 	class AShooterCharacter* ShooterCharacter;
 
@@ -0,0 +1,371 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterBenchmarkGameMode.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "ShooterAnimInstance.h"
+#include "ShooterBotController.h"
+#include "Item.h"
+#include "Weapon.h"
+#include "ItemPoolSubsystem.h"
+#include "ShooterWeaponAudioSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Engine/NetDriver.h"
+#include "IAnimationBudgetAllocator.h"
+
+namespace
+{
+	// Value below which Percent of the sorted samples fall
+	float GetPercentile(const TArray<float>& SortedSamples, float Percent)
+	{
+		if (SortedSamples.Num() == 0)
+			return 0.0f;
+
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percent / 100.0f * SortedSamples.Num()) - 1, 0, SortedSamples.Num() - 1);
+		return SortedSamples[Index];
+	}
+
+	void AppendSummaryRow(FString& Csv, const TCHAR* Name, TArray<float> Samples)
+	{
+		Samples.Sort();
+
+		double Sum = 0.0;
+		for (const float Sample : Samples)
+			Sum += Sample;
+
+		const float Average = Samples.Num() > 0 ? static_cast<float>(Sum / Samples.Num()) : 0.0f;
+		Csv += FString::Printf(TEXT("%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"), Name, Average,
+			GetPercentile(Samples, 50.0f), GetPercentile(Samples, 90.0f), GetPercentile(Samples, 95.0f), GetPercentile(Samples, 99.0f),
+			Samples.Num() > 0 ? Samples.Last() : 0.0f);
+	}
+}
+
+AShooterBenchmarkGameMode::AShooterBenchmarkGameMode()
+	: NumCharacters(32), NumItems(200), NumWeapons(50), WarmupTime(5.0f), Duration(60.0f), GridSpacing(400.0f), bExitWhenDone(true),
+	Random(0), Seed(0), AnimBudgetMs(-1.0f), GridHalfExtent(0.0f), StartRecordingTime(0.0), EndRecordingTime(0.0), bRecording(false), bFinished(false), PhysicsStartCycles(0), PhysicsFrameCycles(0),
+	TimedNetDriver(nullptr), NetTickFlushCycles(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void AShooterBenchmarkGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	NumCharacters = UGameplayStatics::GetIntOption(Options, TEXT("Characters"), NumCharacters);
+	NumItems = UGameplayStatics::GetIntOption(Options, TEXT("Items"), NumItems);
+	NumWeapons = UGameplayStatics::GetIntOption(Options, TEXT("Weapons"), NumWeapons);
+	WarmupTime = UGameplayStatics::GetIntOption(Options, TEXT("Warmup"), FMath::RoundToInt(WarmupTime));
+	Duration = UGameplayStatics::GetIntOption(Options, TEXT("Duration"), FMath::RoundToInt(Duration));
+	Seed = UGameplayStatics::GetIntOption(Options, TEXT("Seed"), Seed);
+	Random.Initialize(Seed);
+
+	if (UGameplayStatics::HasOption(Options, TEXT("AnimBudgetMs")))
+		AnimBudgetMs = FMath::Max(FCString::Atof(*UGameplayStatics::ParseOption(Options, TEXT("AnimBudgetMs"))), 0.0f);
+}
+
+void AShooterBenchmarkGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Before the characters spawn, their meshes register with the allocator in BeginPlay
+	if (AnimBudgetMs >= 0.0f)
+		ApplyAnimationBudget();
+
+	SpawnBenchmarkActors();
+
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsPreTickHandle = PhysScene->OnPhysScenePreTick.AddLambda([this](auto* Scene, float DeltaTime)
+		{
+			PhysicsStartCycles = FPlatformTime::Cycles();
+		});
+		PhysicsPostTickHandle = PhysScene->OnPhysScenePostTick.AddLambda([this](auto* Scene)
+		{
+			PhysicsFrameCycles += FPlatformTime::Cycles() - PhysicsStartCycles;
+		});
+	}
+
+	HookNetTickFlush();
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	StartRecordingTime = Now + WarmupTime;
+	EndRecordingTime = StartRecordingTime + Duration;
+
+	FString Budget = TEXT("default");
+	if (AnimBudgetMs >= 0.0f)
+		Budget = AnimBudgetMs > 0.0f ? FString::Printf(TEXT("%.2f ms"), AnimBudgetMs) : TEXT("off");
+	UE_LOG(LogShooter, Display, TEXT("Benchmark: %d characters, %d items, %d weapons, animation budget %s, recording %.0fs after %.0fs warmup"),
+		Characters.Num(), NumItems, NumWeapons, *Budget, Duration, WarmupTime);
+}
+
+void AShooterBenchmarkGameMode::ApplyAnimationBudget()
+{
+	IAnimationBudgetAllocator* BudgetAllocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (!BudgetAllocator)
+		return;
+
+	if (AnimBudgetMs <= 0.0f)
+	{
+		BudgetAllocator->SetEnabled(false);
+		return;
+	}
+
+	// Also on a dedicated server, which otherwise keeps full rate animation
+	FAnimationBudgetAllocatorParameters Parameters;
+	Parameters.BudgetInMs = AnimBudgetMs;
+	BudgetAllocator->SetParameters(Parameters);
+	BudgetAllocator->SetEnabled(true);
+}
+
+void AShooterBenchmarkGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysScene->OnPhysScenePreTick.Remove(PhysicsPreTickHandle);
+		PhysScene->OnPhysScenePostTick.Remove(PhysicsPostTickHandle);
+	}
+
+	UnhookNetTickFlush();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShooterBenchmarkGameMode::HookNetTickFlush()
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer())
+		return;
+
+	// Replaces the driver's own binding, the order of two handlers on the same event isn't defined
+	TimedNetDriver = NetDriver;
+	GetWorld()->OnTickFlush().RemoveAll(NetDriver);
+	NetTickFlushHandle = GetWorld()->OnTickFlush().AddWeakLambda(NetDriver, [this, NetDriver](float DeltaSeconds)
+	{
+		const uint32 StartCycles = FPlatformTime::Cycles();
+		NetDriver->TickFlush(DeltaSeconds);
+		NetTickFlushCycles += FPlatformTime::Cycles() - StartCycles;
+	});
+}
+
+void AShooterBenchmarkGameMode::UnhookNetTickFlush()
+{
+	if (!TimedNetDriver)
+		return;
+
+	GetWorld()->OnTickFlush().Remove(NetTickFlushHandle);
+	if (IsValid(TimedNetDriver) && TimedNetDriver->GetWorld() == GetWorld())
+		GetWorld()->OnTickFlush().AddUObject(TimedNetDriver, &UNetDriver::TickFlush);
+	TimedNetDriver = nullptr;
+}
+
+void AShooterBenchmarkGameMode::SpawnBenchmarkActors()
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// Characters, items and weapons share one square grid, characters in the middle
+	const int32 NumActors = NumCharacters + NumItems + NumWeapons;
+	const int32 GridSize = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumActors))), 1);
+	GridHalfExtent = (GridSize - 1) * GridSpacing * 0.5f;
+	auto GetGridLocation = [this, GridSize](int32 Index)
+	{
+		return FVector((Index % GridSize) * GridSpacing - GridHalfExtent, (Index / GridSize) * GridSpacing - GridHalfExtent, 200.0f);
+	};
+
+	int32 GridIndex = 0;
+	UClass* SpawnedCharacterClass = CharacterClass ? CharacterClass.Get() : AShooterCharacter::StaticClass();
+	UClass* SpawnedControllerClass = BotControllerClass ? BotControllerClass.Get() : AShooterBotController::StaticClass();
+	for (int32 Index = 0; Index < NumCharacters; Index++)
+	{
+		const FRotator Rotation(0.0f, Random.FRandRange(0.0f, 360.0f), 0.0f);
+		AShooterCharacter* Character = GetWorld()->SpawnActor<AShooterCharacter>(SpawnedCharacterClass, GetGridLocation(GridIndex++), Rotation, SpawnParameters);
+		if (!Character)
+			continue;
+
+		// Every bot gets its own seed derived from the run's, so a run can be repeated exactly
+		Character->AIControllerClass = SpawnedControllerClass;
+		Character->SpawnDefaultController();
+		if (AShooterBotController* Bot = Cast<AShooterBotController>(Character->GetController()))
+			Bot->SetSeed(Seed + Index);
+
+		FBenchmarkCharacter& Scripted = Characters.AddDefaulted_GetRef();
+		Scripted.Character = Character;
+		Scripted.NextPickupTime = Random.FRandRange(2.0f, 6.0f);
+	}
+
+	UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>();
+	if (!ItemPool)
+		return;
+
+	// The pool is sized to hold every item at once, nothing is destroyed during the run
+	UClass* SpawnedItemClass = ItemClass ? ItemClass.Get() : AItem::StaticClass();
+	ItemPool->PrewarmClass(SpawnedItemClass, NumItems);
+	for (int32 Index = 0; Index < NumItems; Index++)
+	{
+		if (AItem* Item = ItemPool->AcquireItem(SpawnedItemClass, FTransform(GetGridLocation(GridIndex++))))
+			Items.Add(Item);
+	}
+
+	UClass* SpawnedWeaponClass = WeaponClass ? WeaponClass.Get() : AWeapon::StaticClass();
+	ItemPool->PrewarmClass(SpawnedWeaponClass, NumWeapons);
+	for (int32 Index = 0; Index < NumWeapons; Index++)
+	{
+		if (AItem* Weapon = ItemPool->AcquireItem(SpawnedWeaponClass, FTransform(GetGridLocation(GridIndex++))))
+			Items.Add(Weapon);
+	}
+}
+
+void AShooterBenchmarkGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bFinished)
+		return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (bRecording)
+	{
+		RecordFrame();
+	}
+	else if (Now >= StartRecordingTime)
+	{
+		// Per-bot tick cost and the weapon audio counters only cover the recorded frames
+		bRecording = true;
+		if (UShooterWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UShooterWeaponAudioSubsystem>())
+			WeaponAudio->ResetStats();
+		for (FBenchmarkCharacter& Scripted : Characters)
+		{
+			if (IsValid(Scripted.Character))
+				Scripted.Character->ResetTickCost();
+		}
+	}
+
+	// Physics, animation and net counters always run, drop what was measured during warmup
+	PhysicsFrameCycles = 0;
+	NetTickFlushCycles = 0;
+	UShooterAnimInstance::ConsumeCycles();
+
+	if (Now >= EndRecordingTime)
+	{
+		FinishBenchmark();
+		return;
+	}
+
+	for (FBenchmarkCharacter& Scripted : Characters)
+		UpdateCharacter(Scripted, Now);
+}
+
+void AShooterBenchmarkGameMode::UpdateCharacter(FBenchmarkCharacter& Scripted, double Now)
+{
+	AShooterCharacter* Character = Scripted.Character;
+	if (!IsValid(Character))
+		return;
+
+	// Picking up a weapon swaps it with the equipped one once the interpolation ends
+	if (Now >= Scripted.NextPickupTime)
+	{
+		if (AItem* Item = FindPickupItem())
+			Item->StartItemInterping(Character);
+
+		RespawnLoot();
+		Scripted.NextPickupTime = Now + Random.FRandRange(3.0f, 8.0f);
+	}
+}
+
+AItem* AShooterBenchmarkGameMode::FindPickupItem()
+{
+	if (Items.Num() == 0)
+		return nullptr;
+
+	// A few random probes are enough, most items lie on the ground
+	for (int32 Attempt = 0; Attempt < 8; Attempt++)
+	{
+		AItem* Item = Items[Random.RandRange(0, Items.Num() - 1)];
+		if (IsValid(Item) && Item->GetItemState() == EItemState::EIS_Pickup)
+			return Item;
+	}
+
+	return nullptr;
+}
+
+void AShooterBenchmarkGameMode::RespawnLoot()
+{
+	UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>();
+	UClass* SpawnedItemClass = ItemClass ? ItemClass.Get() : AItem::StaticClass();
+	if (!ItemPool || ItemPool->GetNumFree(SpawnedItemClass) == 0)
+		return;
+
+	// The actor comes back out of the pool, it is already in Items
+	const FVector Location(Random.FRandRange(-GridHalfExtent, GridHalfExtent), Random.FRandRange(-GridHalfExtent, GridHalfExtent), 200.0f);
+	ItemPool->AcquireItem(SpawnedItemClass, FTransform(Location));
+}
+
+void AShooterBenchmarkGameMode::RecordFrame()
+{
+	// GGameThreadTime and the physics cycles belong to the frame which just finished
+	GameThreadTimes.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	PhysicsTimes.Add(FPlatformTime::ToMilliseconds64(PhysicsFrameCycles));
+	const FShooterAnimCycles AnimCycles = UShooterAnimInstance::ConsumeCycles();
+	AnimUpdateTimes.Add(FPlatformTime::ToMilliseconds64(AnimCycles.Update));
+	AnimThreadSafeUpdateTimes.Add(FPlatformTime::ToMilliseconds64(AnimCycles.ThreadSafeUpdate));
+	AnimGraphGameThreadTimes.Add(FPlatformTime::ToMilliseconds64(AnimCycles.GraphGameThread));
+	AnimGraphWorkerTimes.Add(FPlatformTime::ToMilliseconds64(AnimCycles.GraphWorker));
+	NetBroadcastTimes.Add(FPlatformTime::ToMilliseconds64(NetTickFlushCycles));
+}
+
+void AShooterBenchmarkGameMode::FinishBenchmark()
+{
+	bFinished = true;
+
+	const FString Directory = FPaths::ProfilingDir() / TEXT("Benchmark");
+	const FString Budget = AnimBudgetMs >= 0.0f ? FString::Printf(TEXT("-%.2fab"), AnimBudgetMs) : FString();
+	const FString BaseName = FString::Printf(TEXT("Benchmark-%dc-%di-%dw%s-%s"), Characters.Num(), NumItems, NumWeapons, *Budget, *FDateTime::Now().ToString());
+
+	FString FramesCsv = TEXT("Frame,GameThreadMs,PhysicsMs,AnimUpdateMs,AnimThreadSafeUpdateMs,AnimGraphGameThreadMs,AnimGraphWorkerMs,NetBroadcastMs\n");
+	for (int32 Index = 0; Index < GameThreadTimes.Num(); Index++)
+		FramesCsv += FString::Printf(TEXT("%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"), Index, GameThreadTimes[Index], PhysicsTimes[Index],
+			AnimUpdateTimes[Index], AnimThreadSafeUpdateTimes[Index], AnimGraphGameThreadTimes[Index], AnimGraphWorkerTimes[Index], NetBroadcastTimes[Index]);
+
+	FString SummaryCsv = TEXT("Stat,Average,P50,P90,P95,P99,Max\n");
+	AppendSummaryRow(SummaryCsv, TEXT("GameThreadMs"), GameThreadTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("PhysicsMs"), PhysicsTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("AnimUpdateMs"), AnimUpdateTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("AnimThreadSafeUpdateMs"), AnimThreadSafeUpdateTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("AnimGraphGameThreadMs"), AnimGraphGameThreadTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("AnimGraphWorkerMs"), AnimGraphWorkerTimes);
+	AppendSummaryRow(SummaryCsv, TEXT("NetBroadcastMs"), NetBroadcastTimes);
+
+	const uint64 RecordedFrames = FMath::Max(GameThreadTimes.Num(), 1);
+	FString BotsCsv = TEXT("Bot,TickMs,TickMsPerFrame\n");
+	for (const FBenchmarkCharacter& Scripted : Characters)
+	{
+		if (!IsValid(Scripted.Character))
+			continue;
+
+		const double TickMs = FPlatformTime::ToMilliseconds64(Scripted.Character->GetTickCostCycles());
+		BotsCsv += FString::Printf(TEXT("%s,%.3f,%.4f\n"), *Scripted.Character->GetName(), TickMs, TickMs / RecordedFrames);
+	}
+
+	const FString FramesPath = Directory / BaseName + TEXT(".csv");
+	const FString SummaryPath = Directory / BaseName + TEXT("-Summary.csv");
+	const FString BotsPath = Directory / BaseName + TEXT("-Bots.csv");
+	FFileHelper::SaveStringToFile(FramesCsv, *FramesPath);
+	FFileHelper::SaveStringToFile(SummaryCsv, *SummaryPath);
+	FFileHelper::SaveStringToFile(BotsCsv, *BotsPath);
+
+	UE_LOG(LogShooter, Display, TEXT("Benchmark finished, %d frames written to %s\n%s"), GameThreadTimes.Num(), *FPaths::ConvertRelativePathToFull(SummaryPath), *SummaryCsv);
+
+	if (const UShooterWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UShooterWeaponAudioSubsystem>())
+	{
+		const FWeaponAudioStats& AudioStats = WeaponAudio->GetStats();
+		UE_LOG(LogShooter, Display, TEXT("Benchmark weapon audio: %d peak voices, %d plays, %d voices created, %d steals, %d dropped"),
+			AudioStats.PeakVoices, AudioStats.Plays, AudioStats.VoicesCreated, AudioStats.Steals, AudioStats.Dropped);
+	}
+
+	if (bExitWhenDone)
+		FPlatformMisc::RequestExit(false);
+}
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterGameModeBase.h"
+#include "ShooterBenchmarkGameMode.generated.h"
+
+class AShooterCharacter;
+class AItem;
+class AWeapon;
+class AShooterBotController;
+class UNetDriver;
+
+// Script state of one benchmark character
+USTRUCT()
+struct FBenchmarkCharacter
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AShooterCharacter* Character = nullptr;
+
+	double NextPickupTime = 0.0;
+};
+
+/**
+ * Headless gameplay benchmark. Lays out bot driven characters and loot on a grid around the world
+ * origin of any map, forces regular pickups and weapon swaps, and writes game thread, physics and
+ * animation frame times plus the tick cost of every bot to CSV. Runs on a dedicated server without
+ * clients as well. Loot comes from UItemPoolSubsystem and consumed items respawn from it. Options
+ * come from the travel URL:
+ * ?game=/Script/Shooter.ShooterBenchmarkGameMode?Characters=128?Items=500?Weapons=100?Warmup=5?Duration=60?Seed=0
+ *
+ * ?AnimBudgetMs= sets the animation budget allocator for the run, 0 turns it off. Run once per budget
+ * and compare the anim graph time on the game thread and on the workers.
+ *
+ * On a server the net driver's TickFlush is recorded as well, the work stat NetBroadcastTickTime
+ * measures. Connect clients with -nullrhi to load it, and compare loot replication against
+ * Shooter.Net.ItemDormancy 0 with net.IsPushModelEnabled=0.
+ */
+UCLASS(Config = Game)
+class SHOOTER_API AShooterBenchmarkGameMode : public AShooterGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	AShooterBenchmarkGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Spawns the characters, items and weapons of the run
+	void SpawnBenchmarkActors();
+
+	// Starts a pickup for a character when its time came, bots rarely aim at items on their own
+	void UpdateCharacter(FBenchmarkCharacter& Scripted, double Now);
+
+	// Returns a random item lying on the ground, or null
+	AItem* FindPickupItem();
+
+	// Puts consumed loot back on the ground at a random grid location, like a respawn wave
+	void RespawnLoot();
+
+	// Stores the frame times of the previous frame
+	void RecordFrame();
+
+	// Writes the CSV files and exits when requested
+	void FinishBenchmark();
+
+	// Applies AnimBudgetMs to the world's animation budget allocator
+	void ApplyAnimationBudget();
+
+	// Routes the world's tick flush of the game net driver through a timer, and back
+	void HookNetTickFlush();
+	void UnhookNetTickFlush();
+
+private:
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	TSubclassOf<AShooterCharacter> CharacterClass;
+
+	// Controller possessing every benchmark character
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	TSubclassOf<AShooterBotController> BotControllerClass;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	TSubclassOf<AItem> ItemClass;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	TSubclassOf<AWeapon> WeaponClass;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	int32 NumCharacters;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	int32 NumItems;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	int32 NumWeapons;
+
+	// Seconds before samples are recorded
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	float WarmupTime;
+
+	// Seconds of recorded samples
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	float Duration;
+
+	// Distance between spawn points of the grid
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	float GridSpacing;
+
+	// Quit once the files are written
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Benchmark")
+	bool bExitWhenDone;
+
+	UPROPERTY()
+	TArray<FBenchmarkCharacter> Characters;
+
+	UPROPERTY()
+	TArray<AItem*> Items;
+
+	FRandomStream Random;
+	int32 Seed;
+
+	// Animation budget of the run from ?AnimBudgetMs=, negative leaves the allocator as the game set it up
+	float AnimBudgetMs;
+
+	// Half the width of the spawn grid
+	float GridHalfExtent;
+
+	double StartRecordingTime;
+	double EndRecordingTime;
+	bool bRecording;
+	bool bFinished;
+
+	// Physics time of the current frame, between the physics scene's pre and post tick
+	uint32 PhysicsStartCycles;
+	uint64 PhysicsFrameCycles;
+	FDelegateHandle PhysicsPreTickHandle;
+	FDelegateHandle PhysicsPostTickHandle;
+
+	// Net driver TickFlush time of the current frame
+	UPROPERTY()
+	UNetDriver* TimedNetDriver;
+	uint64 NetTickFlushCycles;
+	FDelegateHandle NetTickFlushHandle;
+
+	// Samples in milliseconds, one per recorded frame
+	TArray<float> GameThreadTimes;
+	TArray<float> PhysicsTimes;
+	TArray<float> AnimUpdateTimes;
+	TArray<float> AnimThreadSafeUpdateTimes;
+	TArray<float> AnimGraphGameThreadTimes;
+	TArray<float> AnimGraphWorkerTimes;
+	TArray<float> NetBroadcastTimes;
+};
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterBotController.h"
+#include "ShooterCharacter.h"
+
+AShooterBotController::AShooterBotController()
+	: ShooterCharacter(nullptr), MoveForwardValue(0.0f), MoveRightValue(0.0f), TurnRateValue(0.0f), LookUpRateValue(0.0f),
+	NextDecisionTime(0.0), NextTriggerTime(0.0), NextSelectTime(0.0), DefaultSeed(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Turn input changes the control rotation, the pawn follows it and not the other way round
+	bSetControlRotationFromPawnOrientation = false;
+
+	Profiles.AddDefaulted();
+}
+
+void AShooterBotController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Spawners that want bots to differ call SetSeed after spawning
+	SetSeed(DefaultSeed);
+}
+
+void AShooterBotController::SetSeed(int32 Seed)
+{
+	Random.Initialize(Seed);
+	if (Profiles.Num() > 0)
+		Profile = Profiles[Random.RandRange(0, Profiles.Num() - 1)];
+
+	NextDecisionTime = 0.0;
+	NextTriggerTime = Random.FRandRange(Profile.BurstPause.X, Profile.BurstPause.Y);
+	NextSelectTime = Random.FRandRange(Profile.SelectInterval.X, Profile.SelectInterval.Y);
+}
+
+void AShooterBotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	ShooterCharacter = Cast<AShooterCharacter>(InPawn);
+	if (ShooterCharacter)
+		SetControlRotation(ShooterCharacter->GetActorRotation());
+}
+
+void AShooterBotController::OnUnPossess()
+{
+	if (ShooterCharacter)
+	{
+		if (ShooterCharacter->IsFireButtonPressed())
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_FireButtonReleased, 0.0f);
+
+		if (ShooterCharacter->GetAiming())
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_AimingButtonReleased, 0.0f);
+	}
+	ShooterCharacter = nullptr;
+
+	Super::OnUnPossess();
+}
+
+void AShooterBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (!ShooterCharacter)
+		return;
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (Now >= NextDecisionTime)
+		MakeDecision(Now);
+
+	// Axis handlers expect to be called every frame, just like input bindings
+	ShooterCharacter->DispatchInput(EShooterInput::ESI_MoveForward, MoveForwardValue);
+	ShooterCharacter->DispatchInput(EShooterInput::ESI_MoveRight, MoveRightValue);
+	ShooterCharacter->DispatchInput(EShooterInput::ESI_TurnAtRate, TurnRateValue);
+	ShooterCharacter->DispatchInput(EShooterInput::ESI_LookUpAtRate, LookUpRateValue);
+
+	// Alternate between bursts of fire and pauses
+	if (Now >= NextTriggerTime)
+	{
+		if (ShooterCharacter->IsFireButtonPressed())
+		{
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_FireButtonReleased, 0.0f);
+			NextTriggerTime = Now + Random.FRandRange(Profile.BurstPause.X, Profile.BurstPause.Y);
+		}
+		else
+		{
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_FireButtonPressed, 0.0f);
+			NextTriggerTime = Now + Random.FRandRange(Profile.BurstDuration.X, Profile.BurstDuration.Y);
+		}
+	}
+
+	// Picks up whatever item the crosshair rests on
+	if (Now >= NextSelectTime)
+	{
+		ShooterCharacter->DispatchInput(EShooterInput::ESI_SelectButtonPressed, 0.0f);
+		ShooterCharacter->DispatchInput(EShooterInput::ESI_SelectButtonReleased, 0.0f);
+		NextSelectTime = Now + Random.FRandRange(Profile.SelectInterval.X, Profile.SelectInterval.Y);
+	}
+
+	// Counted as part of the character's tick cost
+	ShooterCharacter->AddTickCost(FPlatformTime::Cycles() - StartCycles);
+}
+
+void AShooterBotController::MakeDecision(double Now)
+{
+	NextDecisionTime = Now + Random.FRandRange(Profile.DecisionInterval.X, Profile.DecisionInterval.Y);
+
+	if (Random.FRand() < Profile.IdleChance)
+	{
+		MoveForwardValue = 0.0f;
+		MoveRightValue = 0.0f;
+	}
+	else
+	{
+		MoveForwardValue = Random.FRandRange(-1.0f, 1.0f);
+		MoveRightValue = Random.FRandRange(-1.0f, 1.0f);
+	}
+
+	TurnRateValue = Random.FRandRange(-Profile.MaxTurnRate, Profile.MaxTurnRate);
+
+	// Drift back towards the horizon instead of ending up staring at the sky
+	const float Pitch = FRotator::NormalizeAxis(GetControlRotation().Pitch);
+	LookUpRateValue = Random.FRandRange(-Profile.MaxLookUpRate, Profile.MaxLookUpRate) + (Pitch > 20.0f ? Profile.MaxLookUpRate : Pitch < -20.0f ? -Profile.MaxLookUpRate : 0.0f);
+
+	const bool bAim = Random.FRand() < Profile.AimChance;
+	if (bAim != ShooterCharacter->GetAiming())
+	{
+		if (bAim)
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_AimingButtonPressed, 0.0f);
+		else
+			ShooterCharacter->DispatchInput(EShooterInput::ESI_AimingButtonReleased, 0.0f);
+	}
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "ShooterBotController.generated.h"
+
+class AShooterCharacter;
+
+// Ranges a bot draws its randomized behaviour from
+USTRUCT(BlueprintType)
+struct FShooterBotProfile
+{
+	GENERATED_BODY()
+
+	// Seconds between picking a new direction to move and turn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	FVector2D DecisionInterval = FVector2D(1.0f, 3.0f);
+
+	// Chance of standing still for a decision instead of moving
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot", meta = (ClampMin = "0", ClampMax = "1"))
+	float IdleChance = 0.2f;
+
+	// Largest normalized rates passed to TurnAtRate and LookUpAtRate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float MaxTurnRate = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float MaxLookUpRate = 0.1f;
+
+	// Seconds the trigger is held, then released
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	FVector2D BurstDuration = FVector2D(0.2f, 1.5f);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	FVector2D BurstPause = FVector2D(0.5f, 3.0f);
+
+	// Chance of aiming down sights for a decision
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot", meta = (ClampMin = "0", ClampMax = "1"))
+	float AimChance = 0.3f;
+
+	// Seconds between presses of the select button
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	FVector2D SelectInterval = FVector2D(2.0f, 6.0f);
+};
+
+/**
+ * Drives an AShooterCharacter through the same handlers player input uses, with behaviour drawn
+ * from a seeded random stream so soak tests can be repeated
+ */
+UCLASS()
+class SHOOTER_API AShooterBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AShooterBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Restarts the random stream and picks a profile, the same seed always plays the same way
+	void SetSeed(int32 Seed);
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+	// Picks new movement, turning and aiming for the next interval
+	void MakeDecision(double Now);
+
+private:
+	// One of these is picked per bot
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bot", meta = (AllowPrivateAccess = "true"))
+	TArray<FShooterBotProfile> Profiles;
+
+	UPROPERTY()
+	AShooterCharacter* ShooterCharacter;
+
+	FRandomStream Random;
+	FShooterBotProfile Profile;
+
+	// Axis values applied every tick until the next decision
+	float MoveForwardValue;
+	float MoveRightValue;
+	float TurnRateValue;
+	float LookUpRateValue;
+
+	double NextDecisionTime;
+	double NextTriggerTime;
+	double NextSelectTime;
+
+	// Seed used until SetSeed is called
+	UPROPERTY(EditAnywhere, Category = "Bot", meta = (AllowPrivateAccess = "true"))
+	int32 DefaultSeed;
+};
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterCameraZoomComponent.h"
+#include "ShooterCharacter.h"
+
+UShooterCameraZoomComponent::UShooterCameraZoomComponent()
+	: TickInterval(0.0f)
+{
+	// Before the camera manager reads the field of view for this frame's view
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	// The field of view only moves after the aiming button changed
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UShooterCameraZoomComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetComponentTickInterval(TickInterval);
+}
+
+bool UShooterCameraZoomComponent::TickCharacter(float DeltaTime)
+{
+	return ShooterCharacter->CameraInterpZoom(DeltaTime);
+}
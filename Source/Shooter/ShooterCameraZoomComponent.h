@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterCharacterTickComponent.h"
+#include "ShooterCameraZoomComponent.generated.h"
+
+/**
+ * Interpolates the follow camera's field of view towards the aiming or hip fire value
+ */
+UCLASS()
+class SHOOTER_API UShooterCameraZoomComponent : public UShooterCharacterTickComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCameraZoomComponent();
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual bool TickCharacter(float DeltaTime) override;
+
+private:
+	// Tick interval while the field of view moves, 0 ticks every frame
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Camera", meta = (AllowPrivateAccess = "true"))
+	float TickInterval;
+};
@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "ShooterCharacter.h"
+#include "Shooter.h"
 
 #include "Item.h"
 #include "Weapon.h" 
@@ -14,11 +15,68 @@
 #include "Particles/ParticleSystemComponent.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "DrawDebugHelpers.h"
-#include "Components/WidgetComponent.h"
+#include "PickupWidget.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/InputComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "VFXPoolSubsystem.h"
+#include "ItemProximitySubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "LagCompensationSubsystem.h"
+#include "GameFramework/PlayerState.h"
+#include "EngineUtils.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "ShooterCameraZoomComponent.h"
+#include "ShooterCrosshairSpreadComponent.h"
+#include "ShooterItemTraceComponent.h"
+#include "ShooterWeaponAudioComponent.h"
+#include "ProjectileSubsystem.h"
+#include "ItemPoolSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Animation/AnimMontage.h"
+#include "ShooterInputLatencySubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+static TAutoConsoleVariable<int32> CVarAsyncHitscan(
+	TEXT("Shooter.AsyncHitscan"),
+	0,
+	TEXT("0: hitscan traces block the game thread when firing\n")
+	TEXT("1: crosshair and barrel traces are issued asynchronously and resolved next frame"));
+
+static TAutoConsoleVariable<int32> CVarLowLatencyAim(
+	TEXT("Shooter.Input.LowLatencyAim"),
+	0,
+	TEXT("0: a fire press shoots from its input handler with the previous frame's camera\n")
+	TEXT("1: the local player's first shot is resolved later in the same frame, with this frame's aim input and synchronous traces"));
+
+static TAutoConsoleVariable<int32> CVarTrackShotBandwidth(
+	TEXT("Shooter.Net.TrackShotBandwidth"),
+	0,
+	TEXT("Measure received shot batches against one RPC per shot, see Shooter.Net.ShotBandwidth"),
+	ECVF_Default);
+
+// Upper bound of shots the server accepts in one batch
+static constexpr int32 MaxShotsPerBatch = 32;
+
+// Slack on the pickup reach the server accepts, covers the client being ahead of the server's view of it
+static constexpr float PickupRangeTolerance = 100.0f;
+
+DECLARE_CYCLE_STAT(TEXT("FireWeapon"), STAT_FireWeapon, STATGROUP_Shooter);
+DECLARE_CYCLE_STAT(TEXT("TraceUnderCrosshairs"), STAT_TraceUnderCrosshairs, STATGROUP_Shooter);
+DECLARE_CYCLE_STAT(TEXT("TraceForItems"), STAT_TraceForItems, STATGROUP_Shooter);
+DECLARE_CYCLE_STAT(TEXT("CalculateCrosshairSpread"), STAT_CalculateCrosshairSpread, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Traces"), STAT_CrosshairTraces, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Barrel Traces"), STAT_BarrelTraces, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Hitscan Traces"), STAT_AsyncHitscanTraces, STATGROUP_Shooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Traces Saved"), STAT_CrosshairTracesSaved, STATGROUP_Shooter);
 
 // Sets default values
-AShooterCharacter::AShooterCharacter()
-	: BaseTurnRate(45.0f), BaseLookUpRate(45.0f), 
+AShooterCharacter::AShooterCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName)),
+	BaseTurnRate(45.0f), BaseLookUpRate(45.0f), 
 	// Turn / Lookup Rate Configurations when aiming and hip firing
 	HipTurnRate(90.0f),
 	HipLookUpRate(90.0f),
@@ -29,6 +87,8 @@ AShooterCharacter::AShooterCharacter()
 	MouseHipLookUpRate(1.0f),
 	MouseAimingTurnRate(0.2f),
 	MouseAimingLookUpRate(0.2f),
+	// Fire montage is skipped on characters further away
+	FireMontageCullDistance(3000.0f),
 	// Set to true when aiming
 	bAiming(false), 
 	// Camera FOV Configurations
@@ -42,17 +102,25 @@ AShooterCharacter::AShooterCharacter()
 	// Bullet fired timer
 	ShootTimeDuration(0.05f),
 	bFiringBullet(false),
+	bCrosshairSpreadAwake(true),
 	// Automatic fire variables
 	FiringRate(0.1f),
-	bShouldFire(true),
-	bFireButtonPressed(false),
+	bFireButtonPressed(false), bFirePressPending(false),
+	PendingShotBatchTime(0.0),
 	bShouldTraceForItem(false),
+	OverlappedItemCount(0),
+	PickupWidget(nullptr),
 	CameraInterpDistance(250.0f),
-	CameraInterpElevation(65.0f)
+	CameraInterpElevation(65.0f),
+	EmitterPoolBudget(16)
 {
 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	// Callbacks for the two phases of the async hitscan
+	CrosshairTraceDelegate.BindUObject(this, &AShooterCharacter::OnCrosshairTraceDone);
+	BarrelTraceDelegate.BindUObject(this, &AShooterCharacter::OnBarrelTraceDone);
+
 	// Create a camera boom (pulls in towards the character if there is a collision)
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -65,6 +133,16 @@ AShooterCharacter::AShooterCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach camera to the end of spring arm
 	FollowCamera->bUsePawnControlRotation = false; // Camera doesn't rotate relative to the arm)
 
+	// Per-frame work which sleeps while there is nothing to update
+	CameraZoomComponent = CreateDefaultSubobject<UShooterCameraZoomComponent>(TEXT("CameraZoom"));
+	CrosshairSpreadComponent = CreateDefaultSubobject<UShooterCrosshairSpreadComponent>(TEXT("CrosshairSpread"));
+	ItemTraceComponent = CreateDefaultSubobject<UShooterItemTraceComponent>(TEXT("ItemTrace"));
+
+	WeaponAudioComponent = CreateDefaultSubobject<UShooterWeaponAudioComponent>(TEXT("WeaponAudio"));
+	WeaponAudioComponent->SetupAttachment(GetRootComponent());
+
+	InputRecorderComponent = CreateDefaultSubobject<UShooterInputRecorderComponent>(TEXT("InputRecorder"));
+
 	// Don't rotate when the controller rotates. Let controller only affect the camera
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = true;
@@ -81,6 +159,8 @@ void AShooterCharacter::MoveForward(float Value)
 {
 	if ((Controller != nullptr) && Value != 0)
 	{
+		WakeCrosshairSpread();
+
 		// Find out which way is forward
 		const FRotator Rotation = Controller->GetControlRotation();
 		const FRotator YawRotation = { 0.0f, Rotation.Yaw, 0.0f };
@@ -94,6 +174,8 @@ void AShooterCharacter::MoveRight(float Value)
 {
 	if ((Controller != nullptr) && Value != 0)
 	{
+		WakeCrosshairSpread();
+
 		// Find out which way is right
 		const FRotator Rotation = Controller->GetControlRotation();
 		const FRotator YawRotation = { 0.0f, Rotation.Yaw, 0.0f };
@@ -103,6 +185,34 @@ void AShooterCharacter::MoveRight(float Value)
 	}
 }
 
+void AShooterCharacter::AddControllerYawInput(float Val)
+{
+	// Only a local player controller accumulates rotation input, bots turn their control rotation directly
+	if (Val != 0.0f && Controller && !Controller->IsLocalPlayerController())
+	{
+		FRotator ControlRotation = Controller->GetControlRotation();
+		ControlRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw + Val);
+		Controller->SetControlRotation(ControlRotation);
+		return;
+	}
+
+	Super::AddControllerYawInput(Val);
+}
+
+void AShooterCharacter::AddControllerPitchInput(float Val)
+{
+	if (Val != 0.0f && Controller && !Controller->IsLocalPlayerController())
+	{
+		// Player controllers invert pitch input
+		FRotator ControlRotation = Controller->GetControlRotation();
+		ControlRotation.Pitch = FMath::Clamp(FRotator::NormalizeAxis(ControlRotation.Pitch - Val), -89.0f, 89.0f);
+		Controller->SetControlRotation(ControlRotation);
+		return;
+	}
+
+	Super::AddControllerPitchInput(Val);
+}
+
 void AShooterCharacter::TurnAtRate(float Rate)
 {
 	// Calculate delta for this frame from the rate information
@@ -137,49 +247,290 @@ void AShooterCharacter::LookUpWithMouse(float Value)
 	AddControllerPitchInput(Value * LookUpScaleFactor);
 }
 
-void AShooterCharacter::FireWeapon()
+void AShooterCharacter::FireWeapon(const TArray<double>& ShotTimes, bool bResolveNow)
 {
-	if (FireSound)
-		UGameplayStatics::PlaySound2D(this, FireSound);
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_FireWeapon);
+
+	if (ShotTimes.Num() == 0)
+		return;
+
+	// Bots on a dedicated server fire without anyone to see or hear it
+	const bool bPlayCosmetics = GetNetMode() != NM_DedicatedServer;
+
+	if (bPlayCosmetics)
+		WeaponAudioComponent->PlayShots(ShotTimes.Num(), IsLocallyControlled());
 
 	const USkeletalMeshSocket* BarrelSocket = GetMesh()->GetSocketByName("BarrelSocket");
 	if (BarrelSocket)
 	{
 		FTransform BarrelSocketTransform = BarrelSocket->GetSocketTransform(GetMesh());
-		if (MuzzleFlash)
-			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), MuzzleFlash, BarrelSocketTransform);	
+		UVFXPoolSubsystem* VFXPool = bPlayCosmetics ? GetWorld()->GetSubsystem<UVFXPoolSubsystem>() : nullptr;
 
-		FVector BeamEndLocation;
-		bool bBeamEnd = bGetBeamEndLocation(BarrelSocketTransform, BeamEndLocation);
-		  
-		if (bBeamEnd)
+		UShooterInputLatencySubsystem* InputLatency = GetInputLatency();
+		if (InputLatency)
+			InputLatency->MarkFireStage(EInputLatencyStage::EILS_MuzzleFlash);
+
+		const bool bProjectiles = HasProjectileWeapon();
+		const bool bAsyncTraces = !bProjectiles && !bResolveNow && CVarAsyncHitscan.GetValueOnGameThread() != 0;
+
+		// Every shot plays and replicates on its own, the same way MulticastFireShots replays them elsewhere
+		for (const double ShotTime : ShotTimes)
+		{
+			if (WeaponEffects.MuzzleFlash && VFXPool)
+				VFXPool->SpawnEmitter(WeaponEffects.MuzzleFlash, BarrelSocketTransform);
+
+			FVector RayStart;
+			FVector RayEnd;
+			if (!GetShotRay(ShotTime, RayStart, RayEnd))
+				continue;
+
+			if (bProjectiles)
+			{
+				// Launched here without waiting, the server launches its own from the shot batch and only its hits count
+				LaunchProjectile(BarrelSocketTransform.GetLocation(), (RayEnd - BarrelSocketTransform.GetLocation()).GetSafeNormal());
+				QueueReplicatedShot(BarrelSocketTransform, RayEnd, false, ShotTime);
+			}
+			else if (bAsyncTraces)
+			{
+				// Impact and beam are spawned once both traces land
+				StartAsyncBeamTrace(BarrelSocketTransform, RayStart, RayEnd, ShotTime);
+			}
+			else
+			{
+				FVector BeamEndLocation;
+				const bool bHit = bGetBeamEndLocation(BarrelSocketTransform, RayStart, RayEnd, BeamEndLocation);
+				if (bHit && bPlayCosmetics)
+					SpawnBeamEffects(BarrelSocketTransform, BeamEndLocation);
+
+				QueueReplicatedShot(BarrelSocketTransform, BeamEndLocation, bHit, ShotTime);
+			}
+		}
+
+		// The launch is as far as the fire path goes for projectiles, their hits come later with the flight
+		if (InputLatency && !bAsyncTraces)
+			InputLatency->MarkFireStage(EInputLatencyStage::EILS_Trace);
+
+		// Shots owed by the next frame aim from where this one did
+		FVector RayStart;
+		FVector RayEnd;
+		if (GetCrosshairRay(RayStart, RayEnd))
 		{
-			// Spawn impact particles after updating BeamEndPoint
-			if (ImpactParticles)
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactParticles, BeamEndLocation);
+			LastShotRayStart = RayStart;
+			LastShotRayRotation = (RayEnd - RayStart).ToOrientationQuat();
+			LastShotRayTime = GetWorld()->GetTimeSeconds();
+		}
+	}
+
+	if (bPlayCosmetics)
+		PlayFireMontage();
+
+	// Start bullet fire timer for crosshairs
+	StartCrosshairBulletFire();
+}
+
+bool AShooterCharacter::GetShotRay(double ShotTime, FVector& OutStart, FVector& OutEnd)
+{
+	if (!GetCrosshairRay(OutStart, OutEnd))
+		return false;
+
+	// A shot owed now, or the first one since the trigger went down, takes the current ray
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (LastShotRayTime < 0.0 || ShotTime >= Now || LastShotRayTime >= Now)
+		return true;
+
+	const float Alpha = FMath::Clamp(static_cast<float>((ShotTime - LastShotRayTime) / (Now - LastShotRayTime)), 0.0f, 1.0f);
+	const FVector Ray = OutEnd - OutStart;
+	const FQuat Rotation = FQuat::Slerp(LastShotRayRotation, Ray.ToOrientationQuat(), Alpha);
+
+	OutStart = FMath::Lerp(LastShotRayStart, OutStart, Alpha);
+	OutEnd = OutStart + Rotation.GetForwardVector() * Ray.Size();
+	return true;
+}
+
+void AShooterCharacter::LaunchProjectile(const FVector& Origin, const FVector& Direction)
+{
+	if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+		Projectiles->LaunchProjectile(Origin, Direction * EquippedWeapon->GetProjectileSpeed(), EquippedWeapon->GetProjectileParams(WeaponEffects.ImpactParticles), this);
+}
+
+bool AShooterCharacter::HasProjectileWeapon() const
+{
+	return EquippedWeapon && EquippedWeapon->GetFireMode() == EWeaponFireMode::EWFM_Projectile;
+}
+
+void AShooterCharacter::QueueReplicatedShot(const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation, bool bHit, double ShotTime)
+{
+	// The server decides what was hit, using the hitboxes as they were when each shot was fired
+	if (!IsLocallyControlled())
+		return;
+
+	// Convert local shot times to server world time
+	const double LocalNow = GetWorld()->GetTimeSeconds();
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const double ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : LocalNow;
+
+	if (PendingPackedShots.Num() == 0)
+		PendingShotBatchTime = ServerNow - (LocalNow - ShotTime);
+
+	PendingPackedShots.AddDefaulted_GetRef().Pack(MuzzleSocketTransform.GetLocation(), BeamEndLocation, bHit, ServerNow - (LocalNow - ShotTime), PendingShotBatchTime);
+}
 
-			if (BeamParticles)
+void AShooterCharacter::FlushReplicatedShots()
+{
+	if (PendingPackedShots.Num() == 0)
+		return;
+
+	ServerFireShots(PendingShotBatchTime, PendingPackedShots);
+	PendingPackedShots.Reset();
+}
+
+void AShooterCharacter::ServerFireShots_Implementation(double BatchTime, const TArray<FPackedShot>& Shots)
+{
+	if (Shots.Num() == 0 || Shots.Num() > MaxShotsPerBatch)
+		return;
+
+	if (CVarTrackShotBandwidth.GetValueOnGameThread() != 0)
+		ShotBandwidth.CountBatch(BatchTime, Shots);
+
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		const bool bProjectiles = HasProjectileWeapon();
+		for (const FPackedShot& Shot : Shots)
+		{
+			if (!bProjectiles)
 			{
-				UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BeamParticles, BarrelSocketTransform);
-				if (Beam)
-					Beam->SetVectorParameter(FName("Target"), BeamEndLocation);
+				LagCompensation->ConfirmShot(this, Shot.Origin, Shot.GetDirection(), Shot.GetShotTime(BatchTime));
+				continue;
 			}
+
+			// A shooter on this machine launched the authoritative projectiles in FireWeapon already
+			FVector Origin;
+			if (!IsLocallyControlled() && LagCompensation->ClampShotOrigin(this, Shot.Origin, Shot.GetShotTime(BatchTime), Origin))
+				LaunchProjectile(Origin, Shot.GetDirection());
 		}
 	}
 
+	MulticastFireShots(BatchTime, Shots);
+}
+
+void AShooterCharacter::MulticastFireShots_Implementation(double BatchTime, const TArray<FPackedShot>& Shots)
+{
+	// The shooter already played these shots, and nobody watches a dedicated server
+	if (IsLocallyControlled() || GetNetMode() == NM_DedicatedServer || Shots.Num() == 0)
+		return;
+
+	// Batches arrive about once per frame while the trigger is held, which keeps the loop running
+	WeaponAudioComponent->PlayShots(Shots.Num(), false);
+
+	// Projectiles seen by other clients are cosmetic, a listen server already runs the real ones
+	const bool bCosmeticProjectiles = HasProjectileWeapon() && !HasAuthority();
+
+	UVFXPoolSubsystem* VFXPool = GetWorld()->GetSubsystem<UVFXPoolSubsystem>();
+	for (const FPackedShot& Shot : Shots)
+	{
+		const FTransform MuzzleSocketTransform(Shot.GetDirection().Rotation(), Shot.Origin);
+
+		if (WeaponEffects.MuzzleFlash && VFXPool)
+			VFXPool->SpawnEmitter(WeaponEffects.MuzzleFlash, MuzzleSocketTransform);
+
+		if (bCosmeticProjectiles)
+			LaunchProjectile(Shot.Origin, Shot.GetDirection());
+		else if (Shot.HitDistance > 0)
+			SpawnBeamEffects(MuzzleSocketTransform, Shot.GetBeamEnd());
+	}
+
+	PlayFireMontage();
+}
+
+void AShooterCharacter::PlayFireMontage()
+{
+	if (!WeaponEffects.HipFireMontage)
+		return;
+
+	if (!IsLocallyControlled())
+	{
+		// Nobody would see the restart, and the mesh may only be evaluated every few frames
+		if (!GetMesh()->WasRecentlyRendered(0.2f))
+			return;
+
+		const APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+		if (CameraManager && FVector::DistSquared(CameraManager->GetCameraLocation(), GetActorLocation()) > FMath::Square(FireMontageCullDistance))
+			return;
+	}
+
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-	if (AnimInstance && HipFireMontage)
+	if (AnimInstance)
 	{
-		AnimInstance->Montage_Play(HipFireMontage);
+		AnimInstance->Montage_Play(WeaponEffects.HipFireMontage);
 		AnimInstance->Montage_JumpToSection(FName("StartFire"));
 	}
+}
 
-	// Start bullet fire timer for crosshairs
-	StartCrosshairBulletFire();
+void AShooterCharacter::SpawnBeamEffects(const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation)
+{
+	UVFXPoolSubsystem* VFXPool = GetWorld()->GetSubsystem<UVFXPoolSubsystem>();
+	if (!VFXPool)
+		return;
+
+	// Spawn impact particles after updating BeamEndPoint
+	if (WeaponEffects.ImpactParticles)
+		VFXPool->SpawnEmitter(WeaponEffects.ImpactParticles, BeamEndLocation);
+
+	if (WeaponEffects.BeamParticles)
+	{
+		UParticleSystemComponent* Beam = VFXPool->SpawnEmitter(WeaponEffects.BeamParticles, MuzzleSocketTransform);
+		if (Beam)
+			Beam->SetVectorParameter(FName("Target"), BeamEndLocation);
+	}
 }
 
-bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutResult, FVector& OutLocation)
+void AShooterCharacter::RefreshCrosshairCache()
 {
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	const bool bPlayerView = PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager;
+	bool bLatestAimView = false;
+	if (bPlayerView)
+	{
+		CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+		CameraRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+
+		if (CVarLowLatencyAim.GetValueOnGameThread() != 0)
+		{
+			// The camera manager holds last frame's view, swing it around the boom by the aim applied since
+			const FRotator AimRotation = PlayerController->GetControlRotation() + PlayerController->RotationInput;
+			const FQuat DeltaRotation = AimRotation.Quaternion() * CameraRotation.Quaternion().Inverse();
+			const FVector Pivot = CameraBoom->GetComponentLocation();
+			CameraLocation = Pivot + DeltaRotation.RotateVector(CameraLocation - Pivot);
+			CameraRotation = AimRotation;
+			bLatestAimView = true;
+		}
+	}
+	else if (Controller)
+	{
+		// Bots and remote players aim from the eyes along their control rotation
+		GetActorEyesViewPoint(CameraLocation, CameraRotation);
+	}
+
+	// Still valid for this frame and view
+	if (CrosshairCache.FrameNumber == GFrameCounter && CrosshairCache.CameraLocation.Equals(CameraLocation) && CrosshairCache.CameraRotation.Equals(CameraRotation))
+		return;
+
+	CrosshairCache.FrameNumber = GFrameCounter;
+	CrosshairCache.CameraLocation = CameraLocation;
+	CrosshairCache.CameraRotation = CameraRotation;
+	CrosshairCache.bTraced = false;
+
+	// Without a screen, or with a view the viewport doesn't know yet, the crosshair is the view direction itself
+	if (!bPlayerView || bLatestAimView)
+	{
+		CrosshairCache.bValidRay = bLatestAimView || Controller != nullptr;
+		CrosshairCache.RayStart = CameraLocation;
+		CrosshairCache.RayEnd = CameraLocation + (CameraRotation.Vector() * 50000.0f);
+		return;
+	}
+
 	// Get the Viewport Size	
 	FVector2D ViewportSize;
 	if (GEngine && GEngine->GameViewport)
@@ -190,17 +541,52 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutResult, FVector& Out
 	FVector CrosshairWorldLocation;
 	FVector CrosshairWorldDirection;
 
-	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation, CrosshairWorldLocation, CrosshairWorldDirection);
+	CrosshairCache.bValidRay = UGameplayStatics::DeprojectScreenToWorld(PlayerController, CrosshairLocation, CrosshairWorldLocation, CrosshairWorldDirection);
 
-	if (bScreenToWorld)
+	if (CrosshairCache.bValidRay)
 	{
 		// Trace from Crosshair world location outward
-		FVector Start = CrosshairWorldLocation;
-		FVector End = Start + (CrosshairWorldDirection * 50000.0f);
+		CrosshairCache.RayStart = CrosshairWorldLocation;
+		CrosshairCache.RayEnd = CrosshairWorldLocation + (CrosshairWorldDirection * 50000.0f);
+	}
+}
+
+bool AShooterCharacter::GetCrosshairRay(FVector& OutStart, FVector& OutEnd)
+{
+	RefreshCrosshairCache();
+
+	if (CrosshairCache.bValidRay)
+	{
+		OutStart = CrosshairCache.RayStart;
+		OutEnd = CrosshairCache.RayEnd;
+	}
+
+	return CrosshairCache.bValidRay;
+}
+
+bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutResult, FVector& OutLocation)
+{
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_TraceUnderCrosshairs);
+
+	FVector Start;
+	FVector End;
+	if (GetCrosshairRay(Start, End))
+	{
 		OutLocation = End;
 
-		GetWorld()->LineTraceSingleByChannel(OutResult, Start, End, ECollisionChannel::ECC_Visibility);
+		// Only the first consumer this frame pays for the trace
+		if (CrosshairCache.bTraced)
+		{
+			INC_DWORD_STAT(STAT_CrosshairTracesSaved);
+		}
+		else
+		{
+			GetWorld()->LineTraceSingleByChannel(CrosshairCache.HitResult, Start, End, ECollisionChannel::ECC_Visibility);
+			CrosshairCache.bTraced = true;
+			INC_DWORD_STAT(STAT_CrosshairTraces);
+		}
 
+		OutResult = CrosshairCache.HitResult;
 		if (OutResult.bBlockingHit)	
 			return true;
 	}
@@ -210,6 +596,8 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutResult, FVector& Out
 
 void AShooterCharacter::TraceForItems()
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_TraceForItems);
+
 	if (bShouldTraceForItem)
 	{
 		FHitResult ItemTraceResult;
@@ -217,51 +605,156 @@ void AShooterCharacter::TraceForItems()
 		if (TraceUnderCrosshairs(ItemTraceResult, HitLocation))
 		{
 			TraceHitItem = Cast<AItem>(ItemTraceResult.GetActor());
-			if (TraceHitItem && TraceHitItem->GetPickupWidget())
-				TraceHitItem->GetPickupWidget()->SetVisibility(true);
-
-			if (TraceHitItemLastFrame)
-			{
-				// We are hitting a different item this frame from last frame
-				// Thus, we need to hide the widget
-				if (TraceHitItem != TraceHitItemLastFrame)
-					TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
-				
-			}
 
 			// Store a reference to hit item for next frame
 			TraceHitItemLastFrame = TraceHitItem;
 		}
+
+		// The prompt follows whichever item the crosshair points at
+		UpdatePickupWidget(TraceHitItem);
 	}
 	else if (TraceHitItemLastFrame)
 	{
 		// No longer overlapping any items. 
 		// Item last frame should not show widget
-		TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
+		UpdatePickupWidget(nullptr);
+		TraceHitItemLastFrame = nullptr;
+	}
+}
+
+void AShooterCharacter::UpdatePickupWidget(AItem* Item)
+{
+	// Only items lying on the ground can be picked up
+	if (Item && Item->GetItemState() != EItemState::EIS_Pickup)
+		Item = nullptr;
+
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (!PlayerController || !PlayerController->IsLocalController())
+		return;
+
+	if (!PickupWidget && Item && PickupWidgetClass)
+	{
+		PickupWidget = CreateWidget<UPickupWidget>(PlayerController, PickupWidgetClass);
+		if (PickupWidget)
+			PickupWidget->AddToPlayerScreen();
+	}
+
+	if (PickupWidget)
+	{
+		PickupWidget->BindItem(Item);
+		PickupWidget->UpdatePosition(PlayerController);
 	}
 }
 
 AWeapon* AShooterCharacter::SpawnDefaultWeapon()
 {
-	if (DefaultWeaponClass)
-		return GetWorld()->SpawnActor<AWeapon>(DefaultWeaponClass);
+	// Clients receive the server's weapon through EquippedWeapon
+	UClass* WeaponClass = DefaultWeaponClass.Get();
+	if (!WeaponClass || !HasAuthority())
+		return nullptr;
+
+	// Respawned characters pick up weapons parked by the ones before them
+	if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+		return ItemPool->AcquireItem<AWeapon>(WeaponClass, GetActorTransform());
+
+	return GetWorld()->SpawnActor<AWeapon>(WeaponClass);
+}
+
+void AShooterCharacter::RequestWeaponAssets()
+{
+	FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
+
+	// The character can't fire without its weapon, so the class loads ahead of the effects.
+	// Only the server spawns it, clients get it through EquippedWeapon
+	if (HasAuthority())
+	{
+		if (DefaultWeaponClass.Get())
+			EquipWeapon(SpawnDefaultWeapon());
+		else if (!DefaultWeaponClass.IsNull())
+			DefaultWeaponClassHandle = Streamable.RequestAsyncLoad(DefaultWeaponClass.ToSoftObjectPath(),
+				FStreamableDelegate::CreateUObject(this, &AShooterCharacter::OnDefaultWeaponClassLoaded), FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// Nobody sees or hears a dedicated server, and FireWeapon doesn't play the fire montage there either,
+	// its hitboxes follow the locomotion pose
+	TArray<FSoftObjectPath> EffectPaths;
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		EffectPaths.Add(FireSound.ToSoftObjectPath());
+		EffectPaths.Add(FireLoopSound.ToSoftObjectPath());
+		EffectPaths.Add(FireTailSound.ToSoftObjectPath());
+		EffectPaths.Add(MuzzleFlash.ToSoftObjectPath());
+		EffectPaths.Add(ImpactParticles.ToSoftObjectPath());
+		EffectPaths.Add(BeamParticles.ToSoftObjectPath());
+		EffectPaths.Add(HipFireMontage.ToSoftObjectPath());
+	}
+
+	// Characters after the first find everything resident and skip the request
+	EffectPaths.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull() || Path.ResolveObject() != nullptr; });
+	if (EffectPaths.Num() == 0)
+		OnWeaponEffectsLoaded();
+	else
+		WeaponEffectsHandle = Streamable.RequestAsyncLoad(EffectPaths,
+			FStreamableDelegate::CreateUObject(this, &AShooterCharacter::OnWeaponEffectsLoaded), FStreamableManager::DefaultAsyncLoadPriority);
+}
 
-	return nullptr;
+void AShooterCharacter::OnDefaultWeaponClassLoaded()
+{
+	DefaultWeaponClassHandle.Reset();
+	if (!EquippedWeapon)
+		EquipWeapon(SpawnDefaultWeapon());
+}
+
+void AShooterCharacter::OnWeaponEffectsLoaded()
+{
+	WeaponEffectsHandle.Reset();
+
+	// Cosmetics stay null on a dedicated server even when another character loaded them
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		WeaponEffects.FireSound = FireSound.Get();
+		WeaponEffects.FireLoopSound = FireLoopSound.Get();
+		WeaponEffects.FireTailSound = FireTailSound.Get();
+		WeaponEffects.MuzzleFlash = MuzzleFlash.Get();
+		WeaponEffects.ImpactParticles = ImpactParticles.Get();
+		WeaponEffects.BeamParticles = BeamParticles.Get();
+	}
+	WeaponEffects.HipFireMontage = HipFireMontage.Get();
+	WeaponAudioComponent->SetSounds(WeaponEffects.FireSound, WeaponEffects.FireLoopSound, WeaponEffects.FireTailSound);
+
+	// Create the weapon effect components up front so firing never allocates them
+	if (UVFXPoolSubsystem* VFXPool = GetWorld()->GetSubsystem<UVFXPoolSubsystem>())
+	{
+		VFXPool->PrewarmTemplate(WeaponEffects.MuzzleFlash, EmitterPoolBudget);
+		VFXPool->PrewarmTemplate(WeaponEffects.ImpactParticles, EmitterPoolBudget);
+		VFXPool->PrewarmTemplate(WeaponEffects.BeamParticles, EmitterPoolBudget);
+	}
 }
 
 void AShooterCharacter::EquipWeapon(AWeapon* WeaponToEquip)
 {
-	if (WeaponToEquip)
+	if (WeaponToEquip && HasAuthority())
 	{
-		const USkeletalMeshSocket* HandSocket = GetMesh()->GetSocketByName(FName("RightHandSocket"));
-		if (HandSocket)
-			HandSocket->AttachActor(WeaponToEquip, GetMesh());
+		AttachWeapon(WeaponToEquip);
 
 		EquippedWeapon = WeaponToEquip;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, EquippedWeapon, this);
 		EquippedWeapon->SetItemState(EItemState::EIS_Equipped);
 	}
 }
 
+void AShooterCharacter::AttachWeapon(AWeapon* Weapon)
+{
+	const USkeletalMeshSocket* HandSocket = GetMesh()->GetSocketByName(FName("RightHandSocket"));
+	if (Weapon && HandSocket)
+		HandSocket->AttachActor(Weapon, GetMesh());
+}
+
+void AShooterCharacter::OnRep_EquippedWeapon()
+{
+	AttachWeapon(EquippedWeapon);
+}
+
 void AShooterCharacter::DropWeapon()
 {
 	if (EquippedWeapon)
@@ -276,7 +769,22 @@ void AShooterCharacter::DropWeapon()
 void AShooterCharacter::SelectButtonPressed()
 {
 	if (TraceHitItem)
-		TraceHitItem->StartItemInterping(this);
+		ServerPickupItem(TraceHitItem);
+}
+
+void AShooterCharacter::ServerPickupItem_Implementation(AItem* Item)
+{
+	// The client picked what it saw, someone else may have taken the item since
+	if (!IsValid(Item) || Item->IsParkedInPool() || Item->GetItemState() != EItemState::EIS_Pickup)
+		return;
+
+	// Same reach as the proximity query which let the client trace for the item
+	const float PickupRange = Item->GetAreaSphere()->GetScaledSphereRadius() + GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + PickupRangeTolerance;
+	if (FVector::DistSquared(Item->GetActorLocation(), GetActorLocation()) > FMath::Square(PickupRange))
+		return;
+
+	// The interpolation and the swap at its end run here, clients follow the replicated item state
+	Item->StartItemInterping(this);
 }
 
 void AShooterCharacter::SelectButtonReleased()
@@ -292,10 +800,22 @@ void AShooterCharacter::SwapWeapon(AWeapon* WeaponToSwap)
 	TraceHitItemLastFrame = nullptr;
 }
 
-bool AShooterCharacter::bGetBeamEndLocation(const FTransform& MuzzelSocketLocation, FVector& OutBeamLocation)
+bool AShooterCharacter::bGetBeamEndLocation(const FTransform& MuzzelSocketLocation, const FVector& RayStart, const FVector& RayEnd, FVector& OutBeamLocation)
 {
 	FHitResult CrosshairHitResult;
-	bool bCrooshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutBeamLocation);
+	bool bCrooshairHit;
+
+	// Only a shot along the current crosshair ray can share its trace
+	if (IsCrosshairRay(RayStart, RayEnd))
+	{
+		bCrooshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutBeamLocation);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_CrosshairTraces);
+		bCrooshairHit = GetWorld()->LineTraceSingleByChannel(CrosshairHitResult, RayStart, RayEnd, ECollisionChannel::ECC_Visibility);
+		OutBeamLocation = RayEnd;
+	}
 
 	if (bCrooshairHit)
 		OutBeamLocation = CrosshairHitResult.Location;
@@ -306,6 +826,7 @@ bool AShooterCharacter::bGetBeamEndLocation(const FTransform& MuzzelSocketLocati
 	const FVector EndToStart = OutBeamLocation - WeaponTraceStart;
 	const FVector WeaponTraceEnd = WeaponTraceStart + (EndToStart * 1.25f);
 
+	INC_DWORD_STAT(STAT_BarrelTraces);
 	GetWorld()->LineTraceSingleByChannel(WeaponTraceHit, WeaponTraceStart, WeaponTraceEnd, ECollisionChannel::ECC_Visibility);
 
 	// Object between barrel and beam end point.
@@ -318,25 +839,102 @@ bool AShooterCharacter::bGetBeamEndLocation(const FTransform& MuzzelSocketLocati
 	return false;
 }
 
+void AShooterCharacter::StartAsyncBeamTrace(const FTransform& MuzzleSocketTransform, const FVector& RayStart, const FVector& RayEnd, double ShotTime)
+{
+	// The id travels with both traces so the results can find the muzzle transform and time of this shot
+	const uint32 TraceId = NextBeamTraceId++;
+	FPendingBeamTrace& PendingTrace = PendingBeamTraces.Add(TraceId);
+	PendingTrace.MuzzleSocketTransform = MuzzleSocketTransform;
+	PendingTrace.ShotTime = ShotTime;
+
+	// Someone already traced the crosshair this frame and this shot goes along it, skip straight to the barrel phase
+	if (CrosshairCache.bTraced && IsCrosshairRay(RayStart, RayEnd))
+	{
+		INC_DWORD_STAT(STAT_CrosshairTracesSaved);
+		const FVector BeamEndLocation = CrosshairCache.HitResult.bBlockingHit ? FVector(CrosshairCache.HitResult.Location) : RayEnd;
+		StartAsyncBarrelTrace(TraceId, MuzzleSocketTransform, BeamEndLocation);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_AsyncHitscanTraces);
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, RayStart, RayEnd, ECollisionChannel::ECC_Visibility,
+		FCollisionQueryParams::DefaultQueryParam, FCollisionResponseParams::DefaultResponseParam, &CrosshairTraceDelegate, TraceId);
+}
+
+void AShooterCharacter::OnCrosshairTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const FPendingBeamTrace* PendingTrace = PendingBeamTraces.Find(TraceDatum.UserData);
+	if (!PendingTrace)
+		return;
+
+	FVector BeamEndLocation = TraceDatum.End;
+	if (TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit)
+		BeamEndLocation = TraceDatum.OutHits[0].Location;
+
+	StartAsyncBarrelTrace(TraceDatum.UserData, PendingTrace->MuzzleSocketTransform, BeamEndLocation);
+}
+
+void AShooterCharacter::StartAsyncBarrelTrace(uint32 TraceId, const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation)
+{
+	// Second phase, this time from the barrel
+	const FVector WeaponTraceStart = MuzzleSocketTransform.GetLocation();
+	const FVector EndToStart = BeamEndLocation - WeaponTraceStart;
+	const FVector WeaponTraceEnd = WeaponTraceStart + (EndToStart * 1.25f);
+
+	INC_DWORD_STAT(STAT_AsyncHitscanTraces);
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, WeaponTraceStart, WeaponTraceEnd, ECollisionChannel::ECC_Visibility,
+		FCollisionQueryParams::DefaultQueryParam, FCollisionResponseParams::DefaultResponseParam, &BarrelTraceDelegate, TraceId);
+}
+
+void AShooterCharacter::OnBarrelTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FPendingBeamTrace PendingTrace;
+	if (!PendingBeamTraces.RemoveAndCopyValue(TraceDatum.UserData, PendingTrace))
+		return;
+
+	// Object between barrel and beam end point.
+	const bool bHit = TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit;
+	const FVector BeamEndLocation = bHit ? FVector(TraceDatum.OutHits[0].Location) : TraceDatum.End;
+	if (UShooterInputLatencySubsystem* InputLatency = GetInputLatency())
+		InputLatency->MarkFireStage(EInputLatencyStage::EILS_Trace);
+
+	if (bHit && GetNetMode() != NM_DedicatedServer)
+		SpawnBeamEffects(PendingTrace.MuzzleSocketTransform, BeamEndLocation);
+
+	QueueReplicatedShot(PendingTrace.MuzzleSocketTransform, BeamEndLocation, bHit, PendingTrace.ShotTime);
+}
+
 void AShooterCharacter::AimingButtonPressed()
 {
 	bAiming = true;
+	SetBaseTurnAndLookupRate();
+	CameraZoomComponent->Wake();
+	WakeCrosshairSpread();
 }
 
 void AShooterCharacter::AimingButtonReleased()
 {
 	bAiming = false;
+	SetBaseTurnAndLookupRate();
+	CameraZoomComponent->Wake();
+	WakeCrosshairSpread();
 }
 
-void AShooterCharacter::CameraInterpZoom(float DeltaTime)
+bool AShooterCharacter::CameraInterpZoom(float DeltaTime)
 {
 	// Aiming button pressed?
-	if (bAiming)
-		CameraCurrentFov = FMath::FInterpTo(CameraCurrentFov, CameraZoomedFov, DeltaTime, ZoomInterpSpeed);
-	else
-		CameraCurrentFov = FMath::FInterpTo(CameraCurrentFov, CameraDefaultFov, DeltaTime, ZoomInterpSpeed);
+	const float TargetFov = bAiming ? CameraZoomedFov : CameraDefaultFov;
+	if (CameraCurrentFov == TargetFov)
+		return false;
+
+	CameraCurrentFov = FMath::FInterpTo(CameraCurrentFov, TargetFov, DeltaTime, ZoomInterpSpeed);
+
+	// Snap the last fraction of a degree so the zoom can go to sleep
+	if (FMath::IsNearlyEqual(CameraCurrentFov, TargetFov, 0.01f))
+		CameraCurrentFov = TargetFov;
 
 	GetFollowCamera()->SetFieldOfView(CameraCurrentFov);
+	return CameraCurrentFov != TargetFov;
 }
 
 void AShooterCharacter::SetBaseTurnAndLookupRate()
@@ -354,78 +952,149 @@ void AShooterCharacter::SetBaseTurnAndLookupRate()
 
 }
 
-void AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
+bool AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
 {
+	SHOOTER_SCOPE_CYCLE_COUNTER(STAT_CalculateCrosshairSpread);
+
 	// Calculate crosshair velocity factor
 	FVector2D WalkSpeedRange(0.0f, 600.0f);
 	FVector2D VelocityMultiplierRange(0.0f, 1.0f);
 	FVector Velocity = GetVelocity();
 	Velocity.Z = 0;
 
-	CrosshairVelocityFactor = FMath::GetMappedRangeValueClamped(WalkSpeedRange, VelocityMultiplierRange, Velocity.Size());
-	
-	// Calculate crosshair in air factor
-	if (GetCharacterMovement()->IsFalling())
-		// Spread the crosshairs slowly	while in air
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 2.25f, DeltaTime, 2.25);
-	else
-		// Character is on the ground
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 0.0f, DeltaTime, 30.0f);
+	const float VelocityFactor = FMath::GetMappedRangeValueClamped(WalkSpeedRange, VelocityMultiplierRange, Velocity.Size());
 
-	// Calculate crosshair aim factor
-	if (bAiming)
-		// Spread the crosshair quickly while aiming
-		CrosshairAimFactor = FMath::FInterpTo(CrosshairAimFactor, 0.6f, DeltaTime, 30.0f);
-	else
-		// Character is not aiming 
-		CrosshairAimFactor = FMath::FInterpTo(CrosshairAimFactor, 0.0f, DeltaTime, 30.0f); 
+	// Nothing to interpolate until the speed changes or something wakes the spread
+	if (!bCrosshairSpreadAwake && VelocityFactor == CrosshairVelocityFactor)
+		return VelocityFactor > 0.0f;
+
+	CrosshairVelocityFactor = VelocityFactor;
+
+	// Spread the crosshairs slowly while in air, recover quickly on the ground
+	const bool bIsFalling = GetCharacterMovement()->IsFalling();
+	const float InAirTarget = bIsFalling ? 2.25f : 0.0f;
+	CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, InAirTarget, DeltaTime, bIsFalling ? 2.25f : 30.0f);
+
+	// Spread the crosshair quickly while aiming
+	const float AimTarget = bAiming ? 0.6f : 0.0f;
+	CrosshairAimFactor = FMath::FInterpTo(CrosshairAimFactor, AimTarget, DeltaTime, 30.0f);
 
 	// Calculate crosshair shooting factor. It is true 0.05 seconds after firing
-	if (bFiringBullet)
-		CrosshairShootingFactor = FMath::FInterpTo(CrosshairShootingFactor, 0.3f, DeltaTime, 60.0f);
-	else
-		CrosshairShootingFactor = FMath::FInterpTo(CrosshairShootingFactor, 0.0f, DeltaTime, 60.0f);
+	const float ShootingTarget = bFiringBullet ? 0.3f : 0.0f;
+	CrosshairShootingFactor = FMath::FInterpTo(CrosshairShootingFactor, ShootingTarget, DeltaTime, 60.0f);
+
+	// Snap and sleep once every factor arrived
+	if (FMath::IsNearlyEqual(CrosshairInAirFactor, InAirTarget, 0.001f) &&
+		FMath::IsNearlyEqual(CrosshairAimFactor, AimTarget, 0.001f) &&
+		FMath::IsNearlyEqual(CrosshairShootingFactor, ShootingTarget, 0.001f))
+	{
+		CrosshairInAirFactor = InAirTarget;
+		CrosshairAimFactor = AimTarget;
+		CrosshairShootingFactor = ShootingTarget;
+		bCrosshairSpreadAwake = false;
+	}
 
 	CrosshairSpreadMultiplier = 0.5f + CrosshairVelocityFactor + CrosshairInAirFactor - CrosshairAimFactor + CrosshairShootingFactor;	
+
+	// Keep following the speed while moving, movement input alone would miss slowing down
+	return bCrosshairSpreadAwake || VelocityFactor > 0.0f;
+}
+
+void AShooterCharacter::WakeCrosshairSpread()
+{
+	bCrosshairSpreadAwake = true;
+	CrosshairSpreadComponent->Wake();
+}
+
+void AShooterCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+	WakeCrosshairSpread();
+}
+
+void AShooterCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+	ItemTraceComponent->Wake();
+}
+
+bool AShooterCharacter::UpdateItemTrace()
+{
+	if (!IsLocallyControlled())
+	{
+		UpdatePickupWidget(nullptr);
+		return false;
+	}
+
+	UpdateOverlappedItemCount();
+	TraceForItems();
+	return true;
+}
+
+void AShooterCharacter::ResetTickCost()
+{
+	TickCostCycles = 0;
+	TickCostStartFrame = GFrameCounter;
 }
 
 void AShooterCharacter::StartCrosshairBulletFire()
 {
 	bFiringBullet = true;
+	WakeCrosshairSpread();
 	GetWorldTimerManager().SetTimer(CrosshairShootTimer, this, &AShooterCharacter::FinishCrosshairBulletFire, ShootTimeDuration);
 } 
 
 void AShooterCharacter::FinishCrosshairBulletFire()
 {
 	bFiringBullet = false; 
+	WakeCrosshairSpread();
 }
 
 void AShooterCharacter::FireButtonPressed()
 {
 	bFireButtonPressed = true;
-	StartFireTimer();
+
+	if (UShooterInputLatencySubsystem* InputLatency = GetInputLatency())
+		InputLatency->BeginFireMeasurement();
+
+	// First shot fires on the press unless the weapon is still cooling down
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (FireScheduler.PressTrigger(Now))
+	{
+		// Action handlers run before this frame's mouse movement reaches the control rotation
+		if (CVarLowLatencyAim.GetValueOnGameThread() != 0 && IsLocallyControlled() && IsPlayerControlled())
+		{
+			bFirePressPending = true;
+			return;
+		}
+
+		PendingShotTimes.Reset();
+		PendingShotTimes.Add(Now);
+		FireWeapon(PendingShotTimes);
+	}
 }
 
-void AShooterCharacter::FireButtonReleased()
+UShooterInputLatencySubsystem* AShooterCharacter::GetInputLatency() const
 {
-	bFireButtonPressed = false;
+	if (!IsLocallyControlled() || !IsPlayerControlled())
+		return nullptr;
+
+	const UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UShooterInputLatencySubsystem>() : nullptr;
 }
 
-void AShooterCharacter::StartFireTimer()
+void AShooterCharacter::FireButtonReleased()
 {
-	if (bShouldFire)
-	{
-		FireWeapon();
-		bShouldFire = false;
-		GetWorldTimerManager().SetTimer(FireWeaponTimer, this, &AShooterCharacter::ResetFireTimer, FiringRate);
-	}
+	bFireButtonPressed = false;
+	FireScheduler.ReleaseTrigger();
+	WeaponAudioComponent->StopSustainedFire();
 }
 
-void AShooterCharacter::ResetFireTimer()
+void AShooterCharacter::UpdateAutomaticFire()
 {
-	bShouldFire = true;
-	if (bFireButtonPressed)
-		StartFireTimer();
+	PendingShotTimes.Reset();
+	if (FireScheduler.Advance(GetWorld()->GetTimeSeconds(), PendingShotTimes) > 0)
+		FireWeapon(PendingShotTimes);
 }
 
 FVector AShooterCharacter::GetCameraInterpLocation()
@@ -437,26 +1106,32 @@ FVector AShooterCharacter::GetCameraInterpLocation()
 	return (CameraWorldLocation + (CameraForward * CameraInterpDistance) + (FVector(0.0f, 0.0f, CameraInterpElevation))); 
 }
 
-void AShooterCharacter::UpdateTheOverlappedItemCount(int8 amount)
+void AShooterCharacter::UpdateOverlappedItemCount()
 {
-	if (OverlappedItemCount + amount <= 0)
-	{
-		OverlappedItemCount = 0;
-		bShouldTraceForItem = false;
-	}
-	else
-	{
-		OverlappedItemCount += amount;
-		bShouldTraceForItem = true;
-	}
+	UItemProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UItemProximitySubsystem>();
+
+	// The capsule's bounding sphere stands in for the old overlap against the item's area sphere
+	OverlappedItemCount = ProximitySubsystem ? ProximitySubsystem->CountItemsNear(GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleHalfHeight()) : 0;
+	bShouldTraceForItem = OverlappedItemCount > 0;
 }
 
 
 void AShooterCharacter::GetPickupItem(AItem* Item)
 {
+	// Clients learn about the swap and the consumed item through replication
+	if (!HasAuthority())
+		return;
+
 	auto Weapon = Cast<AWeapon>(Item);
 	if (Weapon)
+	{
 		SwapWeapon(Weapon);
+	}
+	else if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		// Other loot is used up on pickup and parked for the next loot spawn
+		ItemPool->ReleaseItem(Item);
+	}
 }
 
 // Called when the game starts or when spawned
@@ -470,8 +1145,64 @@ void AShooterCharacter::BeginPlay()
 		CameraCurrentFov = CameraDefaultFov;
 	}
 
-	// Spawn the default weapon and equip it
-	EquipWeapon(SpawnDefaultWeapon());
+	FireScheduler.SetFiringRate(FiringRate);
+	SetBaseTurnAndLookupRate();
+	ResetTickCost();
+
+	// Record hitbox history for lag compensation on the server
+	if (HasAuthority())
+	{
+		if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+			LagCompensation->RegisterCharacter(this);
+
+		// Nothing renders on a dedicated server, bones still have to follow the animation for the hitboxes
+		if (GetNetMode() == NM_DedicatedServer)
+			GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	}
+
+	// Equip the default weapon and load the effects, right away when they are already resident
+	RequestWeaponAssets();
+}
+
+void AShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Let loads nobody else waits on stop early
+	if (DefaultWeaponClassHandle.IsValid())
+		DefaultWeaponClassHandle->CancelHandle();
+	if (WeaponEffectsHandle.IsValid())
+		WeaponEffectsHandle->CancelHandle();
+
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		LagCompensation->UnregisterCharacter(this);
+
+	// The widget belongs to the player's screen, it would outlive the character there
+	if (PickupWidget)
+	{
+		PickupWidget->RemoveFromParent();
+		PickupWidget = nullptr;
+	}
+
+	// The equipped weapon would otherwise be left floating where the character was
+	if (EndPlayReason == EEndPlayReason::Destroyed && EquippedWeapon && HasAuthority())
+	{
+		if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+			ItemPool->ReleaseItem(EquippedWeapon);
+		EquippedWeapon = nullptr;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, EquippedWeapon, this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShooterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only sent when marked dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, EquippedWeapon, Params);
 }
 
 // Called every frame
@@ -479,17 +1210,25 @@ void AShooterCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// Handle interpolation for zoom when aiming
-	CameraInterpZoom(DeltaTime);
+	const uint32 StartCycles = FPlatformTime::Cycles();
 
-	// Update the turn and lookup rates when aiming
-	SetBaseTurnAndLookupRate();
+	// The controller ticked first, so the aim now includes this frame's input
+	if (bFirePressPending)
+	{
+		bFirePressPending = false;
+		PendingShotTimes.Reset();
+		PendingShotTimes.Add(GetWorld()->GetTimeSeconds());
+		FireWeapon(PendingShotTimes, true);
+	}
 
-	// Calculate crosshair spread multiplier every frame
-	CalculateCrosshairSpread(DeltaTime);
+	// Fire every shot owed since the last frame
+	UpdateAutomaticFire();
 
-	// Trace for AItems when close enough to the object
-	TraceForItems();
+	// Everything fired this frame goes to the server together
+	FlushReplicatedShots();
+
+	// Zoom, crosshair spread and item traces tick in their own components
+	AddTickCost(FPlatformTime::Cycles() - StartCycles);
 }
 
 // Called to bind functionality to input
@@ -498,31 +1237,123 @@ void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
 	check(PlayerInputComponent);
 
+	// Every binding goes through DispatchInput so the input recorder sees the exact stream of handler calls
+
 	// Movement Input
-	PlayerInputComponent->BindAxis("MoveForward", this, &AShooterCharacter::MoveForward);
-	PlayerInputComponent->BindAxis("MoveRight", this, &AShooterCharacter::MoveRight);
+	BindRecordedAxis(PlayerInputComponent, "MoveForward", EShooterInput::ESI_MoveForward);
+	BindRecordedAxis(PlayerInputComponent, "MoveRight", EShooterInput::ESI_MoveRight);
 
 	// Turning At a Rate
-	PlayerInputComponent->BindAxis("TurnRate", this, &AShooterCharacter::TurnAtRate);
-	PlayerInputComponent->BindAxis("LookUpRate", this, &AShooterCharacter::LookUpAtRate);
+	BindRecordedAxis(PlayerInputComponent, "TurnRate", EShooterInput::ESI_TurnAtRate);
+	BindRecordedAxis(PlayerInputComponent, "LookUpRate", EShooterInput::ESI_LookUpAtRate);
 
 	// Turning With Mouse
-	PlayerInputComponent->BindAxis("Turn", this, &AShooterCharacter::TurnWithMouse);
-	PlayerInputComponent->BindAxis("LookUp", this, &AShooterCharacter::LookUpWithMouse);
+	BindRecordedAxis(PlayerInputComponent, "Turn", EShooterInput::ESI_TurnWithMouse);
+	BindRecordedAxis(PlayerInputComponent, "LookUp", EShooterInput::ESI_LookUpWithMouse);
 
 	// Jump Input
-	PlayerInputComponent->BindAction("Jump", EInputEvent::IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", EInputEvent::IE_Released, this, &ACharacter::StopJumping);
+	BindRecordedAction(PlayerInputComponent, "Jump", EInputEvent::IE_Pressed, EShooterInput::ESI_Jump);
+	BindRecordedAction(PlayerInputComponent, "Jump", EInputEvent::IE_Released, EShooterInput::ESI_StopJumping);
 
 	// Fire Input
-	PlayerInputComponent->BindAction("FireButton", EInputEvent::IE_Pressed, this, &AShooterCharacter::FireButtonPressed);
-	PlayerInputComponent->BindAction("FireButton", EInputEvent::IE_Released, this, &AShooterCharacter::FireButtonReleased);
+	BindRecordedAction(PlayerInputComponent, "FireButton", EInputEvent::IE_Pressed, EShooterInput::ESI_FireButtonPressed);
+	BindRecordedAction(PlayerInputComponent, "FireButton", EInputEvent::IE_Released, EShooterInput::ESI_FireButtonReleased);
 
 	// Aiming
-	PlayerInputComponent->BindAction("AimingButton", EInputEvent::IE_Pressed, this, &AShooterCharacter::AimingButtonPressed);
-	PlayerInputComponent->BindAction("AimingButton", EInputEvent::IE_Released, this, &AShooterCharacter::AimingButtonReleased);
+	BindRecordedAction(PlayerInputComponent, "AimingButton", EInputEvent::IE_Pressed, EShooterInput::ESI_AimingButtonPressed);
+	BindRecordedAction(PlayerInputComponent, "AimingButton", EInputEvent::IE_Released, EShooterInput::ESI_AimingButtonReleased);
 	
 	// Selecting
-	PlayerInputComponent->BindAction("Select", EInputEvent::IE_Pressed, this, &AShooterCharacter::SelectButtonPressed);
-	PlayerInputComponent->BindAction("Select", EInputEvent::IE_Released, this, &AShooterCharacter::SelectButtonReleased);
+	BindRecordedAction(PlayerInputComponent, "Select", EInputEvent::IE_Pressed, EShooterInput::ESI_SelectButtonPressed);
+	BindRecordedAction(PlayerInputComponent, "Select", EInputEvent::IE_Released, EShooterInput::ESI_SelectButtonReleased);
+}
+
+void AShooterCharacter::BindRecordedAxis(UInputComponent* PlayerInputComponent, FName AxisName, EShooterInput Input)
+{
+	FInputAxisBinding AxisBinding(AxisName);
+	AxisBinding.AxisDelegate.GetDelegateForManualSet().BindWeakLambda(this, [this, Input](float Value)
+	{
+		// Live input would fight the recording during playback
+		if (InputRecorderComponent->IsPlayingBack())
+			return;
+
+		InputRecorderComponent->RecordInput(Input, Value);
+		DispatchInput(Input, Value);
+	});
+	PlayerInputComponent->AxisBindings.Emplace(MoveTemp(AxisBinding));
 }
+
+void AShooterCharacter::BindRecordedAction(UInputComponent* PlayerInputComponent, FName ActionName, EInputEvent KeyEvent, EShooterInput Input)
+{
+	FInputActionBinding ActionBinding(ActionName, KeyEvent);
+	ActionBinding.ActionDelegate.GetDelegateForManualSet().BindWeakLambda(this, [this, Input]()
+	{
+		if (InputRecorderComponent->IsPlayingBack())
+			return;
+
+		InputRecorderComponent->RecordInput(Input, 0.0f);
+		DispatchInput(Input, 0.0f);
+	});
+	PlayerInputComponent->AddActionBinding(MoveTemp(ActionBinding));
+}
+
+void AShooterCharacter::DispatchInput(EShooterInput Input, float Value)
+{
+	switch (Input)
+	{
+	case EShooterInput::ESI_MoveForward: MoveForward(Value); break;
+	case EShooterInput::ESI_MoveRight: MoveRight(Value); break;
+	case EShooterInput::ESI_TurnAtRate: TurnAtRate(Value); break;
+	case EShooterInput::ESI_LookUpAtRate: LookUpAtRate(Value); break;
+	case EShooterInput::ESI_TurnWithMouse: TurnWithMouse(Value); break;
+	case EShooterInput::ESI_LookUpWithMouse: LookUpWithMouse(Value); break;
+	case EShooterInput::ESI_Jump: Jump(); break;
+	case EShooterInput::ESI_StopJumping: StopJumping(); break;
+	case EShooterInput::ESI_FireButtonPressed: FireButtonPressed(); break;
+	case EShooterInput::ESI_FireButtonReleased: FireButtonReleased(); break;
+	case EShooterInput::ESI_AimingButtonPressed: AimingButtonPressed(); break;
+	case EShooterInput::ESI_AimingButtonReleased: AimingButtonReleased(); break;
+	case EShooterInput::ESI_SelectButtonPressed: SelectButtonPressed(); break;
+	case EShooterInput::ESI_SelectButtonReleased: SelectButtonReleased(); break;
+	default: break;
+	}
+}
+
+static FAutoConsoleCommandWithWorld GShotBandwidthCommand(
+	TEXT("Shooter.Net.ShotBandwidth"),
+	TEXT("Prints the shot bandwidth each player used, batched against one RPC per shot, headers included. Run on the server with Shooter.Net.TrackShotBandwidth 1"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World)
+			return;
+
+		for (TActorIterator<AShooterCharacter> It(World); It; ++It)
+		{
+			const FShotBandwidthStats& Stats = It->GetShotBandwidth();
+			if (Stats.Shots == 0)
+				continue;
+
+			const APlayerState* PlayerState = It->GetPlayerState();
+			UE_LOG(LogShooter, Display, TEXT("%s: %d shots, packed %d RPCs %.1f bits per shot %.0f B/s, naive %d RPCs %.1f bits per shot %.0f B/s"),
+				PlayerState ? *PlayerState->GetPlayerName() : *It->GetName(), Stats.Shots,
+				Stats.PackedRpcs, static_cast<double>(Stats.PackedBits) / Stats.Shots, Stats.GetPackedBytesPerSecond(),
+				Stats.NaiveRpcs, static_cast<double>(Stats.NaiveBits) / Stats.Shots, Stats.GetNaiveBytesPerSecond());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GCharacterTickCostCommand(
+	TEXT("Shooter.Character.TickCost"),
+	TEXT("Prints the game thread time each shooter character spent ticking since the last call, then resets it"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World)
+			return;
+
+		for (TActorIterator<AShooterCharacter> It(World); It; ++It)
+		{
+			const uint64 Frames = FMath::Max<uint64>(GFrameCounter - It->GetTickCostStartFrame(), 1);
+			const double TotalMs = FPlatformTime::ToMilliseconds64(It->GetTickCostCycles());
+			UE_LOG(LogShooter, Display, TEXT("%s: %.3f ms over %llu frames, %.4f ms per frame"), *It->GetName(), TotalMs, Frames, TotalMs / Frames);
+			It->ResetTickCost();
+		}
+	}));
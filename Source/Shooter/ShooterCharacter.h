@@ -4,21 +4,101 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
+#include "FireScheduler.h"
+#include "PackedShot.h"
+#include "Engine/StreamableManager.h"
+#include "ShooterInputRecorderComponent.h"
 #include "ShooterCharacter.generated.h"
 
+// Weapon effects resolved from the character's soft references once they have loaded
+USTRUCT()
+struct FShooterWeaponEffects
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	class USoundCue* FireSound = nullptr;
+
+	UPROPERTY()
+	class USoundBase* FireLoopSound = nullptr;
+
+	UPROPERTY()
+	USoundBase* FireTailSound = nullptr;
+
+	UPROPERTY()
+	class UParticleSystem* MuzzleFlash = nullptr;
+
+	UPROPERTY()
+	UParticleSystem* ImpactParticles = nullptr;
+
+	UPROPERTY()
+	UParticleSystem* BeamParticles = nullptr;
+
+	UPROPERTY()
+	class UAnimMontage* HipFireMontage = nullptr;
+};
+
+// A shot waiting on its async hitscan traces
+struct FPendingBeamTrace
+{
+	FTransform MuzzleSocketTransform;
+	double ShotTime = 0.0;
+};
+
+// Crosshair ray and trace result shared by every consumer within a frame
+struct FCrosshairTraceCache
+{
+	// Frame and camera the cached ray was computed for
+	uint64 FrameNumber = MAX_uint64;
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+
+	// True when the screen center could be deprojected
+	bool bValidRay = false;
+	FVector RayStart = FVector::ZeroVector;
+	FVector RayEnd = FVector::ZeroVector;
+
+	// True once the visibility trace along the ray ran this frame
+	bool bTraced = false;
+	FHitResult HitResult;
+};
+
 UCLASS()
 class SHOOTER_API AShooterCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this character's properties
-	AShooterCharacter();
+	// Sets default values for this character's properties, the mesh is updated under the animation budget
+	AShooterCharacter(const FObjectInitializer& ObjectInitializer);
+
+	// Calls the handler of Input, every input binding, bot and input playback goes through here
+	void DispatchInput(EShooterInput Input, float Value);
+
+	// Per-frame work split out of Tick, each driven by one of the character tick components
+
+	// Moves the field of view towards the aiming or hip value, returns false once it arrived
+	bool CameraInterpZoom(float DeltaTime);
+
+	// Interpolates the spread factors towards their targets, returns false once all of them settled and the character stands still
+	bool CalculateCrosshairSpread(float DeltaTime);
+
+	// Updates the nearby item count and the item under the crosshair, returns false when not locally controlled
+	bool UpdateItemTrace();
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Bind an input to DispatchInput, recording it when the recorder runs and ignoring it during playback
+	void BindRecordedAxis(UInputComponent* PlayerInputComponent, FName AxisName, EShooterInput Input);
+	void BindRecordedAction(UInputComponent* PlayerInputComponent, FName ActionName, EInputEvent KeyEvent, EShooterInput Input);
+
 	// Called forward / backwards input
 	void MoveForward(float Value);
 
@@ -39,22 +119,78 @@ protected:
 
 	void TurnWithMouse(float Value);
 
+	// Rotation input from controllers other than a local player controller is applied to the control rotation
+	virtual void AddControllerYawInput(float Val) override;
+	virtual void AddControllerPitchInput(float Val) override;
+
 	void LookUpWithMouse(float Value);
 
-	// Called when the fire button is pressed
-	void FireWeapon();
+	// Fires every shot in ShotTimes, each along its own ray with its own muzzle flash and beam.
+	// bResolveNow traces on the game thread even when hitscan traces are async
+	void FireWeapon(const TArray<double>& ShotTimes, bool bResolveNow = false);
+
+	// Crosshair ray of a shot owed at ShotTime, between the ray of the last frame that fired and the current one
+	bool GetShotRay(double ShotTime, FVector& OutStart, FVector& OutEnd);
+
+	// Input latency tracking of the local player, null for everyone else
+	class UShooterInputLatencySubsystem* GetInputLatency() const;
+
+	// Traces the shot ray from RayStart to RayEnd, then from the barrel towards what it hit
+	bool bGetBeamEndLocation(const FTransform& MuzzelSocketLocation, const FVector& RayStart, const FVector& RayEnd, FVector& OutBeamLocation);
+
+	// Launches a projectile of the equipped weapon for one shot
+	void LaunchProjectile(const FVector& Origin, const FVector& Direction);
+
+	// True when the equipped weapon fires projectiles
+	bool HasProjectileWeapon() const;
+
+	// Packs a shot resolved this frame into the batch sent at the end of Tick
+	void QueueReplicatedShot(const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation, bool bHit, double ShotTime);
+
+	// Sends the shots queued this frame to the server in a single RPC
+	void FlushReplicatedShots();
 
-	bool bGetBeamEndLocation(const FTransform& MuzzelSocketLocation, FVector& OutBeamLocation);
+	// Validates every shot of a batch against hitboxes rewound to its time, or launches the server's projectiles for it,
+	// then forwards the batch to other clients
+	UFUNCTION(Server, Unreliable)
+	void ServerFireShots(double BatchTime, const TArray<FPackedShot>& Shots);
+
+	// Plays the cosmetic side of a shot batch on clients which didn't fire it
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastFireShots(double BatchTime, const TArray<FPackedShot>& Shots);
+
+	// Restarts the hip fire montage unless the character is too far away or off screen to see it
+	void PlayFireMontage();
+
+	// Spawns impact and beam particles for a shot which hit at BeamEndLocation
+	void SpawnBeamEffects(const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation);
+
+	// Async version of bGetBeamEndLocation, effects are spawned when the barrel trace lands
+	void StartAsyncBeamTrace(const FTransform& MuzzleSocketTransform, const FVector& RayStart, const FVector& RayEnd, double ShotTime);
+
+	// First async phase finished, traces from the barrel towards the crosshair hit
+	void OnCrosshairTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	// Issues the async trace from the barrel towards BeamEndLocation
+	void StartAsyncBarrelTrace(uint32 TraceId, const FTransform& MuzzleSocketTransform, const FVector& BeamEndLocation);
+
+	// Second async phase finished, spawns the beam effects
+	void OnBarrelTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
 
 	// Set bAiming to true or false with button press
 	void AimingButtonPressed();
 	void AimingButtonReleased();
 
-	void CameraInterpZoom(float DeltaTime);
-
 	void SetBaseTurnAndLookupRate();
 
-	void CalculateCrosshairSpread(float DeltaTime);
+	// Resumes spread interpolation after movement or a change in aiming, firing or falling
+	void WakeCrosshairSpread();
+
+	// Wakes the spread when the character starts or stops falling
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+
+	// Item traces only run for a locally controlled character
+	virtual void NotifyControllerChanged() override;
 
 	void StartCrosshairBulletFire();
 
@@ -65,28 +201,61 @@ protected:
 
 	void FireButtonReleased();
 
-	void StartFireTimer();
+	// Fires the shots the scheduler owes up to this frame
+	void UpdateAutomaticFire();
 
-	UFUNCTION()
-	void ResetFireTimer();
+	// Deprojects the screen center into a world space ray, computed once per frame and camera transform
+	bool GetCrosshairRay(FVector& OutStart, FVector& OutEnd);
+
+	// Invalidates CrosshairCache when the frame or camera transform changed
+	void RefreshCrosshairCache();
+
+	// True when the ray is this frame's crosshair ray, whose trace CrosshairCache shares
+	FORCEINLINE bool IsCrosshairRay(const FVector& Start, const FVector& End) const { return CrosshairCache.bValidRay && Start == CrosshairCache.RayStart && End == CrosshairCache.RayEnd; }
 
 	// Traces under the crosshair to register what we hit
 	bool TraceUnderCrosshairs(FHitResult& OutResult, FVector& OutLocation);
 
+	// Binds the shared pickup prompt to Item, or hides it when Item is null
+	void UpdatePickupWidget(class AItem* Item);
+
+	// Counts the pickup items within reach using the proximity registry
+	void UpdateOverlappedItemCount();
+
 	// Trace for items if OverlappedItemCount > 0
 	void TraceForItems();
 
-	// Spawns a default weapon and equips it
+	// Spawns a default weapon, null while its class is still loading
 	class AWeapon* SpawnDefaultWeapon();
 
-	// Takes a weapon and attaches it to a mesh
+	// Starts loading whatever weapon assets are missing, the weapon class ahead of the effects
+	void RequestWeaponAssets();
+
+	// Equips the default weapon once its class has loaded
+	void OnDefaultWeaponClassLoaded();
+
+	// Caches the loaded effects and prewarms their emitter pools
+	void OnWeaponEffectsLoaded();
+
+	// Takes a weapon and attaches it to a mesh, server only
 	void EquipWeapon(AWeapon* WeaponToEquip);
 
+	// Attaches the weapon to the right hand socket
+	void AttachWeapon(AWeapon* Weapon);
+
+	// Attaches the weapon the server equipped, its movement isn't replicated while it is held
+	UFUNCTION()
+	void OnRep_EquippedWeapon();
+
 	// Detach weapon and let it fall to the ground
 	void DropWeapon();
 
 	void SelectButtonPressed();
 
+	// Picks up Item on the server once it checked the item is still on the ground and within reach
+	UFUNCTION(Server, Reliable)
+	void ServerPickupItem(AItem* Item);
+
 	void SelectButtonReleased();
 
 	// Releases the EquippedWeapon and Equips the TraceHitItem
@@ -150,23 +319,43 @@ private:
 
 	// Randomized gunshot sound cue
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	class USoundCue* FireSound;
+	TSoftObjectPtr<USoundCue> FireSound;
+
+	// Loops while the trigger is held on automatic fire, replaces FireSound after the first shot of a burst
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundBase> FireLoopSound;
+
+	// Played when the fire loop ends
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundBase> FireTailSound;
 
 	// Flash spawned at BarrelSocket
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	class UParticleSystem* MuzzleFlash;
+	TSoftObjectPtr<UParticleSystem> MuzzleFlash;
 
 	// Particles spawned upon bullet impact
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	UParticleSystem* ImpactParticles;
+	TSoftObjectPtr<UParticleSystem> ImpactParticles;
 
 	// Smoke trail for bullets.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	UParticleSystem* BeamParticles;
+	TSoftObjectPtr<UParticleSystem> BeamParticles;
 
 	// Montage for firing the weapon
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	class UAnimMontage* HipFireMontage;
+	TSoftObjectPtr<UAnimMontage> HipFireMontage;
+
+	// The effects above once loaded, null until then and for cosmetics on a dedicated server
+	UPROPERTY(Transient)
+	FShooterWeaponEffects WeaponEffects;
+
+	// In flight loads of the default weapon class and of the weapon effects
+	TSharedPtr<FStreamableHandle> DefaultWeaponClassHandle;
+	TSharedPtr<FStreamableHandle> WeaponEffectsHandle;
+
+	// Other characters further than this from the local camera skip the fire montage
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float FireMontageCullDistance;
 
 	// True when aiming
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
@@ -209,40 +398,63 @@ private:
 	bool bFiringBullet;
 	FTimerHandle CrosshairShootTimer;
 
+	// False while every spread factor sits at its target
+	bool bCrosshairSpreadAwake;
+
 	// Rate of automatic gun fire
 	float FiringRate;
 
-	// True when can fire, false when waiting for the timer
-	bool bShouldFire;
-
 	// Left mouse button or right console trigger pressed
 	bool bFireButtonPressed;
 
-	// Sets a timer	between gunshots
-	FTimerHandle FireWeaponTimer;
+	// Emits shots at FiringRate while the fire button is held
+	FFireScheduler FireScheduler;
+
+	// Shot times of the current frame, kept to avoid reallocating
+	TArray<double> PendingShotTimes;
+
+	// Low latency aim: the press's first shot waits for Tick, after the controller applied this frame's aim
+	bool bFirePressPending;
+
+	// Shots waiting to be sent to the server, timed relative to PendingShotBatchTime
+	TArray<FPackedShot> PendingPackedShots;
+
+	// Server world time of the first shot in PendingPackedShots
+	double PendingShotBatchTime;
+
+	// Shot payload received from this player, only counted with Shooter.Net.TrackShotBandwidth
+	FShotBandwidthStats ShotBandwidth;
 
 	// True when the overlapped item count is greater than zero
 	bool bShouldTraceForItem;
 
-	// Number of overlapped AItems
-	int8 OverlappedItemCount;
+	// Number of AItems whose pickup radius reaches the character
+	int32 OverlappedItemCount;
 
 	// The AItem we hit last frame
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
 	class AItem* TraceHitItemLastFrame;
 
-	// Currently equipped weapon
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true")) 
+	// Currently equipped weapon, spawned and swapped by the server
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_EquippedWeapon, Category = "Combat", meta = (AllowPrivateAccess = "true")) 
 	AWeapon* EquippedWeapon;
 
 	// Set this in blueprints for default Weapon class
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
-	TSubclassOf<AWeapon> DefaultWeaponClass;
+	TSoftClassPtr<AWeapon> DefaultWeaponClass;
 
 	// The item currently hit by our trace in TraceForItems (could be null)
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
 	AItem* TraceHitItem;
 
+	// Pickup prompt shown for the item under the crosshair
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
+	TSubclassOf<class UPickupWidget> PickupWidgetClass;
+
+	// The single pickup prompt of this local player, created on first use
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
+	UPickupWidget* PickupWidget;
+
 	// Distance outward from the camera for interpolation destination
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
 	float CameraInterpDistance;
@@ -251,19 +463,67 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
 	float CameraInterpElevation;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	class UShooterCameraZoomComponent* CameraZoomComponent;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	class UShooterCrosshairSpreadComponent* CrosshairSpreadComponent;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	class UShooterItemTraceComponent* ItemTraceComponent;
+
+	// Plays the fire sounds through a few recycled voices
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	class UShooterWeaponAudioComponent* WeaponAudioComponent;
+
+	// Records the player's input and plays recordings back
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	UShooterInputRecorderComponent* InputRecorderComponent;
+
+	// Cycles spent in Tick and the tick components since TickCostStartFrame
+	uint64 TickCostCycles = 0;
+	uint64 TickCostStartFrame = 0;
+
+	// Crosshair query of the current frame
+	FCrosshairTraceCache CrosshairCache;
+
+	// Delegates receiving the async hitscan results
+	FTraceDelegate CrosshairTraceDelegate;
+	FTraceDelegate BarrelTraceDelegate;
+
+	// Shots waiting on their async traces, keyed by trace user data
+	TMap<uint32, FPendingBeamTrace> PendingBeamTraces;
+
+	// Id handed to the next async shot
+	uint32 NextBeamTraceId = 0;
+
+	// Crosshair ray of the last frame that fired, shots owed since then aim along the way to the current ray
+	FVector LastShotRayStart = FVector::ZeroVector;
+	FQuat LastShotRayRotation = FQuat::Identity;
+	double LastShotRayTime = -1.0;
+
+	// Number of pooled components kept per weapon effect, the oldest effect is recycled past this
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	int32 EmitterPoolBudget;
+
 public:
 	// Getters
 	FORCEINLINE USpringArmComponent* GetSpringArmComponent() const { return CameraBoom; };
 	FORCEINLINE UCameraComponent* GetFollowCamera() const { return FollowCamera; };
 	FORCEINLINE bool GetAiming() const { return bAiming; }
-	FORCEINLINE int8 GetOverlappedItemCount() const { return OverlappedItemCount; };
+	FORCEINLINE bool IsFireButtonPressed() const { return bFireButtonPressed; }
+	FORCEINLINE int32 GetOverlappedItemCount() const { return OverlappedItemCount; };
+	FORCEINLINE const FShotBandwidthStats& GetShotBandwidth() const { return ShotBandwidth; }
 	UFUNCTION(BlueprintCallable)
 	float GetCrosshairSpreadMultiplier() const { return CrosshairSpreadMultiplier; }
-	FVector GetCameraInterpLocation();
+	FORCEINLINE bool IsCrosshairSpreadAwake() const { return bCrosshairSpreadAwake; }
 
-	// Setters
-	// Set the bShouldTraceForItem and OverlappedItemCount based on our overlapped event
-	void UpdateTheOverlappedItemCount(int8 amount);
+	// Per-character tick cost, read by Shooter.Character.TickCost
+	FORCEINLINE void AddTickCost(uint32 Cycles) { TickCostCycles += Cycles; }
+	FORCEINLINE uint64 GetTickCostCycles() const { return TickCostCycles; }
+	FORCEINLINE uint64 GetTickCostStartFrame() const { return TickCostStartFrame; }
+	void ResetTickCost();
+	FVector GetCameraInterpLocation();
 
 	// Utilities
 	void GetPickupItem(AItem* Item);
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterCharacterTickComponent.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Character Component Ticks"), STAT_CharacterComponentTicks, STATGROUP_Shooter);
+
+UShooterCharacterTickComponent::UShooterCharacterTickComponent()
+	: ShooterCharacter(nullptr)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void UShooterCharacterTickComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ShooterCharacter = Cast<AShooterCharacter>(GetOwner());
+	if (!ShooterCharacter)
+		Sleep();
+}
+
+void UShooterCharacterTickComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	INC_DWORD_STAT(STAT_CharacterComponentTicks);
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	const bool bKeepTicking = TickCharacter(DeltaTime);
+	ShooterCharacter->AddTickCost(FPlatformTime::Cycles() - StartCycles);
+
+	if (!bKeepTicking)
+		Sleep();
+}
+
+void UShooterCharacterTickComponent::Wake()
+{
+	if (!IsComponentTickEnabled())
+		SetComponentTickEnabled(true);
+}
+
+void UShooterCharacterTickComponent::Sleep()
+{
+	if (IsComponentTickEnabled())
+		SetComponentTickEnabled(false);
+}
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ShooterCharacterTickComponent.generated.h"
+
+class AShooterCharacter;
+
+/**
+ * Runs one piece of per-frame character work. The component turns its own tick off once
+ * the work reaches a steady state and the character wakes it on the events that matter
+ */
+UCLASS(Abstract)
+class SHOOTER_API UShooterCharacterTickComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCharacterTickComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Resumes ticking, does nothing when already awake
+	void Wake();
+
+	// Stops ticking until the next Wake
+	void Sleep();
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Does the work of one tick, returns false once there is nothing left to update
+	virtual bool TickCharacter(float DeltaTime) PURE_VIRTUAL(UShooterCharacterTickComponent::TickCharacter, return false;);
+
+	// Owner, cached on BeginPlay
+	UPROPERTY()
+	AShooterCharacter* ShooterCharacter;
+};
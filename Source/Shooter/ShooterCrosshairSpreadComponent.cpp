@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterCrosshairSpreadComponent.h"
+#include "ShooterCharacter.h"
+
+UShooterCrosshairSpreadComponent::UShooterCrosshairSpreadComponent()
+	: TickInterval(0.0f)
+{
+	// Reads the velocity movement produced this frame
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UShooterCrosshairSpreadComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetComponentTickInterval(TickInterval);
+}
+
+bool UShooterCrosshairSpreadComponent::TickCharacter(float DeltaTime)
+{
+	return ShooterCharacter->CalculateCrosshairSpread(DeltaTime);
+}
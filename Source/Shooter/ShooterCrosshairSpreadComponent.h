@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterCharacterTickComponent.h"
+#include "ShooterCrosshairSpreadComponent.generated.h"
+
+/**
+ * Interpolates the crosshair spread factors
+ */
+UCLASS()
+class SHOOTER_API UShooterCrosshairSpreadComponent : public UShooterCharacterTickComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCrosshairSpreadComponent();
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual bool TickCharacter(float DeltaTime) override;
+
+private:
+	// Tick interval while the spread changes, 0 ticks every frame
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	float TickInterval;
+};
@@ -2,4 +2,23 @@
 
 
 #include "ShooterGameModeBase.h"
+#include "IAnimationBudgetAllocator.h"
+#include "ShooterHUD.h"
+#include "ShooterPlayerController.h"
 
+AShooterGameModeBase::AShooterGameModeBase()
+{
+	HUDClass = AShooterHUD::StaticClass();
+	PlayerControllerClass = AShooterPlayerController::StaticClass();
+}
+
+void AShooterGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// A dedicated server keeps full rate animation for the lag compensation hitboxes, everywhere
+	// else the local player controller enables the budget
+	IAnimationBudgetAllocator* BudgetAllocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (BudgetAllocator && GetNetMode() == NM_DedicatedServer)
+		BudgetAllocator->SetEnabled(false);
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterHUD.h"
+#include "ShooterCharacter.h"
+#include "Engine/Canvas.h"
+#include "Engine/Texture2D.h"
+
+AShooterHUD::AShooterHUD()
+	: CrosshairCenter(nullptr), CrosshairLeft(nullptr), CrosshairRight(nullptr), CrosshairTop(nullptr), CrosshairBottom(nullptr),
+	CrosshairSize(64.0f), CrosshairSpreadMax(16.0f), CrosshairVerticalOffset(0.0f)
+{
+}
+
+void AShooterHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	const AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(GetOwningPawn());
+	if (!ShooterCharacter || !Canvas)
+		return;
+
+	const FVector2D Center(Canvas->ClipX * 0.5f, Canvas->ClipY * 0.5f - CrosshairVerticalOffset);
+	const float Spread = ShooterCharacter->GetCrosshairSpreadMultiplier() * CrosshairSpreadMax;
+
+	DrawCrosshairPart(CrosshairCenter, Center, FVector2D::ZeroVector);
+	DrawCrosshairPart(CrosshairLeft, Center, FVector2D(-Spread, 0.0f));
+	DrawCrosshairPart(CrosshairRight, Center, FVector2D(Spread, 0.0f));
+	DrawCrosshairPart(CrosshairTop, Center, FVector2D(0.0f, -Spread));
+	DrawCrosshairPart(CrosshairBottom, Center, FVector2D(0.0f, Spread));
+}
+
+void AShooterHUD::DrawCrosshairPart(UTexture2D* Texture, const FVector2D& Center, const FVector2D& Offset)
+{
+	if (!Texture)
+		return;
+
+	const FVector2D Position = Center + Offset - FVector2D(CrosshairSize * 0.5f);
+	DrawTexture(Texture, Position.X, Position.Y, CrosshairSize, CrosshairSize, 0.0f, 0.0f, 1.0f, 1.0f);
+}
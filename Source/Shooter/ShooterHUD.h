@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "ShooterHUD.generated.h"
+
+class UTexture2D;
+
+/**
+ * Draws the crosshair natively from the spread the owning character caches
+ */
+UCLASS()
+class SHOOTER_API AShooterHUD : public AHUD
+{
+	GENERATED_BODY()
+
+public:
+	AShooterHUD();
+
+	virtual void DrawHUD() override;
+
+protected:
+	void DrawCrosshairPart(UTexture2D* Texture, const FVector2D& Center, const FVector2D& Offset);
+
+private:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairCenter;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairLeft;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairRight;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairTop;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairBottom;
+
+	// Size each crosshair texture is drawn at
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	float CrosshairSize;
+
+	// Pixels the outer parts move away from the center per unit of spread multiplier
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	float CrosshairSpreadMax;
+
+	// Moves the crosshair up from the screen center, the weapon traces always aim at the exact center
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crosshairs", meta = (AllowPrivateAccess = "true"))
+	float CrosshairVerticalOffset;
+};
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterInputLatencySubsystem.h"
+#include "Shooter.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "GameFramework/InputSettings.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+// A press older than this when the handler runs didn't cause the fire, it came from a bot or input playback
+static constexpr double MaxFirePressAgeSeconds = 0.5;
+
+// Notes the time the fire keys go down, before Slate routes the event anywhere
+class FShooterFireInputProcessor : public IInputProcessor
+{
+public:
+	FShooterFireInputProcessor()
+	{
+		TArray<FInputActionKeyMapping> Mappings;
+		UInputSettings::GetInputSettings()->GetActionMappingByName(FName("FireButton"), Mappings);
+		for (const FInputActionKeyMapping& Mapping : Mappings)
+			FireKeys.Add(Mapping.Key);
+	}
+
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override
+	{
+		if (!InKeyEvent.IsRepeat())
+			NotePress(InKeyEvent.GetKey());
+		return false;
+	}
+
+	virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override
+	{
+		NotePress(MouseEvent.GetEffectingButton());
+		return false;
+	}
+
+	// Returns the time of the latest fire key press and forgets it, zero when there was none
+	double ConsumeFirePress()
+	{
+		const double PressSeconds = LastFirePressSeconds;
+		LastFirePressSeconds = 0.0;
+		return PressSeconds;
+	}
+
+private:
+	void NotePress(const FKey& Key)
+	{
+		if (FireKeys.Contains(Key))
+			LastFirePressSeconds = FPlatformTime::Seconds();
+	}
+
+	TSet<FKey> FireKeys;
+	double LastFirePressSeconds = 0.0;
+};
+
+void FInputLatencyHistogram::Add(float LatencyMs)
+{
+	int32 Bucket = 0;
+	while (Bucket < NumBuckets - 1 && LatencyMs > BucketLimitsMs[Bucket])
+		Bucket++;
+
+	Counts[Bucket]++;
+	NumSamples++;
+	TotalMs += LatencyMs;
+	MaxMs = FMath::Max(MaxMs, LatencyMs);
+}
+
+bool UShooterInputLatencySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nobody presses anything on a dedicated server
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UShooterInputLatencySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FSlateApplication::IsInitialized())
+	{
+		InputProcessor = MakeShared<FShooterFireInputProcessor>();
+		FSlateApplication::Get().RegisterInputPreProcessor(InputProcessor);
+	}
+}
+
+void UShooterInputLatencySubsystem::Deinitialize()
+{
+	if (InputProcessor.IsValid() && FSlateApplication::IsInitialized())
+		FSlateApplication::Get().UnregisterInputPreProcessor(InputProcessor);
+	InputProcessor.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShooterInputLatencySubsystem::BeginFireMeasurement()
+{
+	ActivePressSeconds = 0.0;
+	RecordedStages = 0;
+
+	const double PressSeconds = InputProcessor.IsValid() ? InputProcessor->ConsumeFirePress() : 0.0;
+	if (PressSeconds <= 0.0 || FPlatformTime::Seconds() - PressSeconds > MaxFirePressAgeSeconds)
+		return;
+
+	ActivePressSeconds = PressSeconds;
+	MarkFireStage(EInputLatencyStage::EILS_Handler);
+}
+
+void UShooterInputLatencySubsystem::MarkFireStage(EInputLatencyStage Stage)
+{
+	if (ActivePressSeconds <= 0.0)
+		return;
+
+	const uint8 StageBit = 1 << static_cast<uint8>(Stage);
+	if (RecordedStages & StageBit)
+		return;
+
+	RecordedStages |= StageBit;
+	Histograms[static_cast<int32>(Stage)].Add(static_cast<float>((FPlatformTime::Seconds() - ActivePressSeconds) * 1000.0));
+
+	if (Stage == EInputLatencyStage::EILS_Trace)
+		ActivePressSeconds = 0.0;
+}
+
+void UShooterInputLatencySubsystem::ResetHistograms()
+{
+	for (FInputLatencyHistogram& Histogram : Histograms)
+		Histogram = FInputLatencyHistogram();
+}
+
+void UShooterInputLatencySubsystem::LogHistograms() const
+{
+	static const TCHAR* StageNames[] = { TEXT("Handler"), TEXT("MuzzleFlash"), TEXT("Trace") };
+	static_assert(UE_ARRAY_COUNT(StageNames) == static_cast<int32>(EInputLatencyStage::EILS_MAX), "Every stage needs a name");
+
+	for (int32 Stage = 0; Stage < UE_ARRAY_COUNT(StageNames); Stage++)
+	{
+		const FInputLatencyHistogram& Histogram = Histograms[Stage];
+		const double AverageMs = Histogram.NumSamples > 0 ? Histogram.TotalMs / Histogram.NumSamples : 0.0;
+		UE_LOG(LogShooter, Display, TEXT("Press to %s: %d samples, avg %.2f ms, max %.2f ms"), StageNames[Stage], Histogram.NumSamples, AverageMs, Histogram.MaxMs);
+
+		for (int32 Bucket = 0; Bucket < FInputLatencyHistogram::NumBuckets; Bucket++)
+		{
+			if (Histogram.Counts[Bucket] == 0)
+				continue;
+
+			const FString Range = Bucket < FInputLatencyHistogram::NumBuckets - 1
+				? FString::Printf(TEXT("<= %5.1f ms"), FInputLatencyHistogram::BucketLimitsMs[Bucket])
+				: FString::Printf(TEXT(" > %5.1f ms"), FInputLatencyHistogram::BucketLimitsMs[Bucket - 1]);
+			const int32 BarLength = FMath::CeilToInt(40.0f * Histogram.Counts[Bucket] / Histogram.NumSamples);
+			UE_LOG(LogShooter, Display, TEXT("  %s %6d %s"), *Range, Histogram.Counts[Bucket], *FString::ChrN(BarLength, TEXT('#')));
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GInputLatencyHistogramCommand(
+	TEXT("Shooter.Input.LatencyHistogram"),
+	TEXT("Prints the latency from a fire key press to the fire handler, muzzle flash and resolved trace. Args: [reset]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		UShooterInputLatencySubsystem* InputLatency = GameInstance ? GameInstance->GetSubsystem<UShooterInputLatencySubsystem>() : nullptr;
+		if (!InputLatency)
+			return;
+
+		InputLatency->LogHistograms();
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+			InputLatency->ResetHistograms();
+	}));
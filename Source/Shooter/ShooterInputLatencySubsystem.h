@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ShooterInputLatencySubsystem.generated.h"
+
+class FShooterFireInputProcessor;
+
+// Points of the fire path timed from the press, in the order they happen
+enum class EInputLatencyStage : uint8
+{
+	// FireButtonPressed ran
+	EILS_Handler,
+
+	// The muzzle flash of the first shot was spawned
+	EILS_MuzzleFlash,
+
+	// The hitscan traces of the first shot resolved, or its projectiles were launched
+	EILS_Trace,
+
+	EILS_MAX
+};
+
+// Latency samples of one stage in fixed millisecond buckets
+struct FInputLatencyHistogram
+{
+	// Upper limits of every bucket but the last, which takes everything slower
+	static constexpr float BucketLimitsMs[] = { 1.0f, 2.0f, 4.0f, 8.0f, 12.0f, 16.7f, 20.0f, 25.0f, 33.3f, 50.0f, 66.7f, 100.0f };
+	static constexpr int32 NumBuckets = UE_ARRAY_COUNT(BucketLimitsMs) + 1;
+
+	int32 Counts[NumBuckets] = {};
+	int32 NumSamples = 0;
+	double TotalMs = 0.0;
+	float MaxMs = 0.0f;
+
+	void Add(float LatencyMs);
+};
+
+/**
+ * Times a fire press from the moment Slate receives the OS input event to the fire handler, the
+ * muzzle flash and the resolved traces of the first shot, and keeps a histogram per stage
+ */
+UCLASS()
+class SHOOTER_API UShooterInputLatencySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Starts timing the press behind this fire, does nothing when no fire key went down recently
+	void BeginFireMeasurement();
+
+	// Records the latency of Stage once per press, the trace stage ends the measurement
+	void MarkFireStage(EInputLatencyStage Stage);
+
+	FORCEINLINE const FInputLatencyHistogram& GetHistogram(EInputLatencyStage Stage) const { return Histograms[static_cast<int32>(Stage)]; }
+	void ResetHistograms();
+
+	// Prints every stage's histogram to the log
+	void LogHistograms() const;
+
+private:
+	// Sees OS input events before any widget or player input does
+	TSharedPtr<FShooterFireInputProcessor> InputProcessor;
+
+	// Platform seconds of the press being measured, zero when none is
+	double ActivePressSeconds = 0.0;
+
+	// Bit per stage already recorded for the active press
+	uint8 RecordedStages = 0;
+
+	FInputLatencyHistogram Histograms[static_cast<int32>(EInputLatencyStage::EILS_MAX)];
+};
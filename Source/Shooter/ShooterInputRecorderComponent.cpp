@@ -0,0 +1,378 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterInputRecorderComponent.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+static TAutoConsoleVariable<float> CVarInputRecordStepHz(
+	TEXT("Shooter.Input.FixedStepHz"),
+	60.0f,
+	TEXT("Fixed simulation rate of new input recordings, playback always uses the rate of the recording"));
+
+static TAutoConsoleVariable<int32> CVarInputExitAfterPlayback(
+	TEXT("Shooter.Input.ExitAfterPlayback"),
+	0,
+	TEXT("Quit once an input playback has finished and its checksum was compared"));
+
+// "SHIN", then the format version
+static constexpr uint32 ShooterInputMagic = 0x4E494853;
+static constexpr uint32 ShooterInputVersion = 1;
+
+// Set on the input byte of an axis whose value differs from its previous call
+static constexpr uint8 ShooterInputValueChanged = 0x80;
+
+UShooterInputRecorderComponent::UShooterInputRecorderComponent()
+	: Mode(EMode::Idle), bRunStartPending(false), bStopRequested(false), StartFrame(0), NextInput(0),
+	FixedDeltaTime(1.0f / 60.0f), RandomSeed(0), NumFrames(0), TransformChecksum(0),
+	StartLocation(FVector::ZeroVector), StartRotation(FRotator::ZeroRotator), StartControlRotation(FRotator::ZeroRotator), StartVelocity(FVector::ZeroVector),
+	bPreviousUseFixedTimeStep(false), PreviousFixedDeltaTime(0.0)
+{
+	// Driven by AShooterPlayerController right after live input
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UShooterInputRecorderComponent::StartRecording(const FString& Name)
+{
+	if (Mode != EMode::Idle || !GetRecordingPath(Name, FilePath))
+		return false;
+
+	MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	FixedDeltaTime = 1.0f / FMath::Max(CVarInputRecordStepHz.GetValueOnGameThread(), 1.0f);
+	RandomSeed = FMath::Rand();
+	NumFrames = 0;
+	TransformChecksum = 0;
+	Inputs.Reset();
+
+	Mode = EMode::Recording;
+	bRunStartPending = true;
+	bStopRequested = false;
+	return true;
+}
+
+void UShooterInputRecorderComponent::StopRecording()
+{
+	if (Mode == EMode::Recording)
+		bStopRequested = true;
+}
+
+bool UShooterInputRecorderComponent::StartPlayback(const FString& Name)
+{
+	if (Mode != EMode::Idle || !GetRecordingPath(Name, FilePath))
+		return false;
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+	{
+		UE_LOG(LogShooter, Warning, TEXT("Input playback: can't read %s"), *FilePath);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	SerializeRecording(Reader);
+	if (Reader.IsError())
+	{
+		UE_LOG(LogShooter, Warning, TEXT("Input playback: %s is not a valid recording"), *FilePath);
+		Inputs.Reset();
+		return false;
+	}
+
+	const FString CurrentMapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	if (MapName != CurrentMapName)
+		UE_LOG(LogShooter, Warning, TEXT("Input playback: recorded on %s but playing on %s, the checksum won't match"), *MapName, *CurrentMapName);
+
+	Mode = EMode::PlayingBack;
+	bRunStartPending = true;
+	return true;
+}
+
+void UShooterInputRecorderComponent::StartCommandLinePlayback()
+{
+	FString Name;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ShooterInputPlayback="), Name))
+		StartPlayback(Name);
+}
+
+void UShooterInputRecorderComponent::RecordInput(EShooterInput Input, float Value)
+{
+	if (Mode != EMode::Recording || bRunStartPending)
+		return;
+
+	Inputs.Add({ static_cast<uint32>(GFrameCounter - StartFrame), Input, Value });
+}
+
+void UShooterInputRecorderComponent::TickInput()
+{
+	if (Mode == EMode::Idle)
+		return;
+
+	if (bRunStartPending)
+		BeginRun();
+
+	if (Mode == EMode::Recording)
+	{
+		if (bStopRequested)
+			FinishRecording();
+		return;
+	}
+
+	// Both runs take the checksum at the same point, the input step of the last frame
+	const uint32 Frame = static_cast<uint32>(GFrameCounter - StartFrame);
+	if (Frame >= NumFrames)
+	{
+		FinishPlayback();
+		return;
+	}
+
+	AShooterCharacter* Character = GetOwner<AShooterCharacter>();
+	if (!Character)
+		return;
+
+	while (NextInput < Inputs.Num() && Inputs[NextInput].Frame <= Frame)
+	{
+		Character->DispatchInput(Inputs[NextInput].Input, Inputs[NextInput].Value);
+		NextInput++;
+	}
+}
+
+uint32 UShooterInputRecorderComponent::ComputeTransformChecksum(UWorld* World)
+{
+	TArray<AShooterCharacter*> Characters;
+	for (TActorIterator<AShooterCharacter> It(World); It; ++It)
+		Characters.Add(*It);
+
+	// Spawn order and therefore names repeat between runs, iteration order doesn't have to
+	Characters.Sort([](const AShooterCharacter& A, const AShooterCharacter& B) { return A.GetFName().LexicalLess(B.GetFName()); });
+
+	uint32 Crc = 0;
+	for (const AShooterCharacter* Character : Characters)
+	{
+		const FVector Location = Character->GetActorLocation();
+		const FQuat Rotation = Character->GetActorQuat();
+		const double Values[] = { Location.X, Location.Y, Location.Z, Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+		Crc = FCrc::MemCrc32(Values, sizeof(Values), Crc);
+	}
+
+	return Crc;
+}
+
+bool UShooterInputRecorderComponent::GetRecordingPath(const FString& Name, FString& OutPath)
+{
+	// Recordings stay in their own directory
+	if (Name.IsEmpty() || Name.Contains(TEXT("/")) || Name.Contains(TEXT("\\")) || Name.Contains(TEXT(":")) || Name.Contains(TEXT("..")))
+	{
+		UE_LOG(LogShooter, Warning, TEXT("Input recorder: '%s' is not a valid recording name"), *Name);
+		return false;
+	}
+
+	OutPath = FPaths::ProfilingDir() / TEXT("Input") / Name + TEXT(".shinput");
+	return true;
+}
+
+void UShooterInputRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// A run cut short by the level ending leaves no file and no verdict, only the timestep to restore
+	if (Mode != EMode::Idle && !bRunStartPending)
+		EndRun();
+	Mode = EMode::Idle;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UShooterInputRecorderComponent::SerializeRecording(FArchive& Ar)
+{
+	uint32 Magic = ShooterInputMagic;
+	uint32 Version = ShooterInputVersion;
+	Ar << Magic;
+	Ar << Version;
+	if (Ar.IsLoading() && (Magic != ShooterInputMagic || Version != ShooterInputVersion))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << MapName;
+	Ar << FixedDeltaTime;
+	Ar << RandomSeed;
+	Ar << NumFrames;
+	Ar << TransformChecksum;
+	Ar << StartLocation;
+	Ar << StartRotation;
+	Ar << StartControlRotation;
+	Ar << StartVelocity;
+
+	int32 NumInputs = Inputs.Num();
+	Ar << NumInputs;
+	if (Ar.IsLoading())
+	{
+		if (Ar.IsError() || NumInputs < 0 || NumInputs > Ar.TotalSize())
+		{
+			Ar.SetError();
+			return;
+		}
+		Inputs.SetNumZeroed(NumInputs);
+	}
+
+	// Frames are stored as deltas and axes only carry a value when it changed, most calls take two bytes
+	uint32 PreviousFrame = 0;
+	float AxisValues[NumShooterInputAxes] = {};
+	for (FRecordedInput& Recorded : Inputs)
+	{
+		uint32 FrameDelta = Recorded.Frame - PreviousFrame;
+		Ar.SerializeIntPacked(FrameDelta);
+		Recorded.Frame = PreviousFrame + FrameDelta;
+		PreviousFrame = Recorded.Frame;
+
+		uint8 InputByte = static_cast<uint8>(Recorded.Input);
+		if (Ar.IsSaving() && IsShooterInputAxis(Recorded.Input) && Recorded.Value != AxisValues[InputByte])
+			InputByte |= ShooterInputValueChanged;
+		Ar << InputByte;
+
+		Recorded.Input = static_cast<EShooterInput>(InputByte & ~ShooterInputValueChanged);
+		if (Ar.IsError() || Recorded.Input >= EShooterInput::ESI_MAX)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		if (!IsShooterInputAxis(Recorded.Input))
+			continue;
+
+		const int32 Axis = static_cast<int32>(Recorded.Input);
+		if (InputByte & ShooterInputValueChanged)
+		{
+			Ar << Recorded.Value;
+			AxisValues[Axis] = Recorded.Value;
+		}
+		else
+		{
+			Recorded.Value = AxisValues[Axis];
+		}
+	}
+}
+
+void UShooterInputRecorderComponent::BeginRun()
+{
+	bRunStartPending = false;
+	StartFrame = GFrameCounter;
+	NextInput = 0;
+
+	// Every frame advances the game by the same step, whatever the machine's frame rate
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedDeltaTime);
+
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	AShooterCharacter* Character = GetOwner<AShooterCharacter>();
+	if (!Character)
+		return;
+
+	AController* Controller = Character->GetController();
+	UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	if (Mode == EMode::Recording)
+	{
+		StartLocation = Character->GetActorLocation();
+		StartRotation = Character->GetActorRotation();
+		StartControlRotation = Controller ? Controller->GetControlRotation() : StartRotation;
+		StartVelocity = Movement->Velocity;
+	}
+	else
+	{
+		// The input only reproduces the run when it is applied to the same starting point
+		Character->SetActorLocationAndRotation(StartLocation, StartRotation, false, nullptr, ETeleportType::ResetPhysics);
+		if (Controller)
+			Controller->SetControlRotation(StartControlRotation);
+		Movement->Velocity = StartVelocity;
+	}
+}
+
+void UShooterInputRecorderComponent::EndRun()
+{
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+	Mode = EMode::Idle;
+}
+
+void UShooterInputRecorderComponent::FinishRecording()
+{
+	bStopRequested = false;
+	NumFrames = static_cast<uint32>(GFrameCounter - StartFrame);
+	TransformChecksum = ComputeTransformChecksum(GetWorld());
+
+	// Input of the final frame arrived after the checksum point and would never be played
+	while (Inputs.Num() > 0 && Inputs.Last().Frame >= NumFrames)
+		Inputs.Pop(false);
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	SerializeRecording(Writer);
+	EndRun();
+
+	if (FFileHelper::SaveArrayToFile(Bytes, *FilePath))
+		UE_LOG(LogShooter, Display, TEXT("Input recording: %u frames, %d inputs, %d bytes, checksum %08x written to %s"),
+			NumFrames, Inputs.Num(), Bytes.Num(), TransformChecksum, *FPaths::ConvertRelativePathToFull(FilePath));
+	else
+		UE_LOG(LogShooter, Warning, TEXT("Input recording: can't write %s"), *FilePath);
+}
+
+void UShooterInputRecorderComponent::FinishPlayback()
+{
+	const uint32 Checksum = ComputeTransformChecksum(GetWorld());
+	EndRun();
+
+	if (Checksum == TransformChecksum)
+		UE_LOG(LogShooter, Display, TEXT("Input playback: %u frames, checksum %08x matches the recording"), NumFrames, Checksum);
+	else
+		UE_LOG(LogShooter, Warning, TEXT("Input playback: %u frames, checksum %08x differs from the recorded %08x, the run was not deterministic"), NumFrames, Checksum, TransformChecksum);
+
+	if (CVarInputExitAfterPlayback.GetValueOnGameThread() != 0)
+		FPlatformMisc::RequestExit(false);
+}
+
+// The recorder of the first local player's character
+static UShooterInputRecorderComponent* FindLocalInputRecorder(UWorld* World)
+{
+	const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	return Pawn ? Pawn->FindComponentByClass<UShooterInputRecorderComponent>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GInputRecordCommand(
+	TEXT("Shooter.Input.Record"),
+	TEXT("Starts recording the local player's input. Args: [Name=Recording]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterInputRecorderComponent* Recorder = FindLocalInputRecorder(World);
+		if (!Recorder || !Recorder->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("Recording")))
+			UE_LOG(LogShooter, Warning, TEXT("Input recording: no idle local shooter character"));
+	}));
+
+static FAutoConsoleCommandWithWorld GInputStopRecordingCommand(
+	TEXT("Shooter.Input.StopRecording"),
+	TEXT("Ends the input recording and writes its file"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterInputRecorderComponent* Recorder = FindLocalInputRecorder(World))
+			Recorder->StopRecording();
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputPlayCommand(
+	TEXT("Shooter.Input.Play"),
+	TEXT("Plays an input recording back through the local player's character. Args: Name"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterInputRecorderComponent* Recorder = FindLocalInputRecorder(World);
+		if (Args.Num() > 0 && Recorder)
+			Recorder->StartPlayback(Args[0]);
+	}));
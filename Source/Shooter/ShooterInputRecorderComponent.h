@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ShooterInputRecorderComponent.generated.h"
+
+class AShooterCharacter;
+
+// Every input binding of AShooterCharacter, axes first
+enum class EShooterInput : uint8
+{
+	ESI_MoveForward,
+	ESI_MoveRight,
+	ESI_TurnAtRate,
+	ESI_LookUpAtRate,
+	ESI_TurnWithMouse,
+	ESI_LookUpWithMouse,
+
+	ESI_Jump,
+	ESI_StopJumping,
+	ESI_FireButtonPressed,
+	ESI_FireButtonReleased,
+	ESI_AimingButtonPressed,
+	ESI_AimingButtonReleased,
+	ESI_SelectButtonPressed,
+	ESI_SelectButtonReleased,
+
+	ESI_MAX
+};
+
+static constexpr int32 NumShooterInputAxes = static_cast<int32>(EShooterInput::ESI_LookUpWithMouse) + 1;
+
+FORCEINLINE bool IsShooterInputAxis(EShooterInput Input) { return static_cast<int32>(Input) < NumShooterInputAxes; }
+
+// One call of an input handler, Value is only used by axes
+struct FRecordedInput
+{
+	// Frames since the run started
+	uint32 Frame;
+	EShooterInput Input;
+	float Value;
+};
+
+/**
+ * Records every input handler call of the local player's character to a binary file, and plays a
+ * recording back through the same handlers. Both run on a fixed timestep with a seeded random
+ * stream from the same character start state, and end with a checksum of every character
+ * transform so replays can be compared. AShooterPlayerController drives it after live input
+ */
+UCLASS(ClassGroup = (Input))
+class SHOOTER_API UShooterInputRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterInputRecorderComponent();
+
+	// Starts recording on the next TickInput, returns false when already busy
+	bool StartRecording(const FString& Name);
+
+	// Ends the recording on the next TickInput and writes the file
+	void StopRecording();
+
+	// Loads a recording and starts feeding it on the next TickInput
+	bool StartPlayback(const FString& Name);
+
+	// Starts the playback named by -ShooterInputPlayback=, if any
+	void StartCommandLinePlayback();
+
+	// Called by the input bindings before the handler runs
+	void RecordInput(EShooterInput Input, float Value);
+
+	// Called by the player controller after it processed live input, begins and ends runs and feeds this frame's recorded input
+	void TickInput();
+
+	FORCEINLINE bool IsRecording() const { return Mode == EMode::Recording; }
+	FORCEINLINE bool IsPlayingBack() const { return Mode == EMode::PlayingBack; }
+
+	// CRC of the transform of every shooter character in World, in name order
+	static uint32 ComputeTransformChecksum(UWorld* World);
+
+	// Path of the recording Name under the profiling directory, false when Name would leave that directory
+	static bool GetRecordingPath(const FString& Name, FString& OutPath);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		PlayingBack
+	};
+
+	// Header and input stream, used for both reading and writing
+	void SerializeRecording(FArchive& Ar);
+
+	// Fixes the timestep, seeds the random stream and captures or restores the character's start state
+	void BeginRun();
+
+	// Restores the timestep the run replaced
+	void EndRun();
+
+	void FinishRecording();
+	void FinishPlayback();
+
+	EMode Mode;
+
+	// Set by Start and Stop, applied on the next TickInput so runs line up with the input step
+	bool bRunStartPending;
+	bool bStopRequested;
+
+	uint64 StartFrame;
+	int32 NextInput;
+	FString FilePath;
+
+	// Recording contents
+	FString MapName;
+	float FixedDeltaTime;
+	int32 RandomSeed;
+	uint32 NumFrames;
+	uint32 TransformChecksum;
+	TArray<FRecordedInput> Inputs;
+
+	// Character state when the recording started, playback starts from it as well
+	FVector StartLocation;
+	FRotator StartRotation;
+	FRotator StartControlRotation;
+	FVector StartVelocity;
+
+	// Timestep settings to restore once the run ends
+	bool bPreviousUseFixedTimeStep;
+	double PreviousFixedDeltaTime;
+};
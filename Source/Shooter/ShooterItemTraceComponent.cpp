@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterItemTraceComponent.h"
+#include "ShooterCharacter.h"
+
+UShooterItemTraceComponent::UShooterItemTraceComponent()
+	: IdleTickInterval(0.1f)
+{
+	// Traces from the camera after the character moved
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+bool UShooterItemTraceComponent::TickCharacter(float DeltaTime)
+{
+	if (!ShooterCharacter->UpdateItemTrace())
+		return false;
+
+	// Every frame while the pickup prompt may be shown, otherwise only poll for items coming into reach
+	SetComponentTickInterval(ShooterCharacter->GetOverlappedItemCount() > 0 ? 0.0f : IdleTickInterval);
+	return true;
+}
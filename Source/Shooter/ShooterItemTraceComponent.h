@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterCharacterTickComponent.h"
+#include "ShooterItemTraceComponent.generated.h"
+
+/**
+ * Counts nearby items and traces the crosshair for the one to pick up
+ */
+UCLASS()
+class SHOOTER_API UShooterItemTraceComponent : public UShooterCharacterTickComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterItemTraceComponent();
+
+protected:
+	virtual bool TickCharacter(float DeltaTime) override;
+
+private:
+	// Tick interval while no item is within reach
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Items", meta = (AllowPrivateAccess = "true"))
+	float IdleTickInterval;
+};
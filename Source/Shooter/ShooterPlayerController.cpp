@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterPlayerController.h"
+#include "ShooterInputRecorderComponent.h"
+#include "IAnimationBudgetAllocator.h"
+
+AShooterPlayerController::AShooterPlayerController()
+	: AnimationBudgetMs(1.0f), bCommandLinePlaybackStarted(false)
+{
+}
+
+void AShooterPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Runs on listen servers and clients alike, remote players' controllers are left out
+	if (!IsLocalController())
+		return;
+
+	IAnimationBudgetAllocator* BudgetAllocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (!BudgetAllocator)
+		return;
+
+	// Distant and off screen meshes are evaluated less often and interpolated in between
+	if (AnimationBudgetMs >= 0.0f)
+	{
+		FAnimationBudgetAllocatorParameters Parameters;
+		Parameters.BudgetInMs = AnimationBudgetMs;
+		BudgetAllocator->SetParameters(Parameters);
+	}
+	BudgetAllocator->SetEnabled(true);
+}
+
+void AShooterPlayerController::ProcessPlayerInput(const float DeltaTime, const bool bGamePaused)
+{
+	Super::ProcessPlayerInput(DeltaTime, bGamePaused);
+
+	UShooterInputRecorderComponent* Recorder = GetInputRecorder();
+	if (!Recorder)
+		return;
+
+	if (!bCommandLinePlaybackStarted)
+	{
+		bCommandLinePlaybackStarted = true;
+		Recorder->StartCommandLinePlayback();
+	}
+
+	// Live input bindings just ran, recorded input and run boundaries go in the same place
+	Recorder->TickInput();
+}
+
+UShooterInputRecorderComponent* AShooterPlayerController::GetInputRecorder() const
+{
+	const APawn* ControlledPawn = GetPawn();
+	return ControlledPawn ? ControlledPawn->FindComponentByClass<UShooterInputRecorderComponent>() : nullptr;
+}
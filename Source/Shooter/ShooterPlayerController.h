@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "ShooterPlayerController.generated.h"
+
+class UShooterInputRecorderComponent;
+
+/**
+ * Feeds recorded input to the possessed shooter character right after live input was processed,
+ * so playback reaches the handlers at the same point of the frame as the recorded input did.
+ * The local player's controller also sets up the animation budget of its world
+ */
+UCLASS()
+class SHOOTER_API AShooterPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AShooterPlayerController();
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void ProcessPlayerInput(const float DeltaTime, const bool bGamePaused) override;
+
+	// Game thread time per frame the budgeted character meshes may spend on animation. Negative values
+	// keep the a.Budget.BudgetMs default, which also changes the budget at runtime
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Animation")
+	float AnimationBudgetMs;
+
+private:
+	// Input recorder of the possessed pawn, null when it has none
+	UShooterInputRecorderComponent* GetInputRecorder() const;
+
+	// -ShooterInputPlayback= plays once in this controller's world, not again for every respawned character
+	bool bCommandLinePlaybackStarted;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Standalone game world for automation tests. Spawned actors run BeginPlay like in a level,
+ * and everything spawned into the world is destroyed with it when the helper goes out of scope
+ */
+class FShooterTestWorld
+{
+public:
+	FShooterTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		World->AddToRoot();
+
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+	}
+
+	~FShooterTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+	}
+
+	FShooterTestWorld(const FShooterTestWorld&) = delete;
+	FShooterTestWorld& operator=(const FShooterTestWorld&) = delete;
+
+	UWorld* Get() const { return World; }
+
+	// Ticks actors, components and tickable subsystems by DeltaTime
+	void Tick(float DeltaTime) { World->Tick(LEVELTICK_All, DeltaTime); }
+
+private:
+	UWorld* World;
+};
+
+#endif
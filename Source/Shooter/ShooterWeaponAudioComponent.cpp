@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterWeaponAudioComponent.h"
+#include "Shooter.h"
+#include "ShooterWeaponAudioSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Sounds Played"), STAT_WeaponSoundsPlayed, STATGROUP_Shooter);
+
+UShooterWeaponAudioComponent::UShooterWeaponAudioComponent()
+	: ShotSound(nullptr), LoopSound(nullptr), TailSound(nullptr), LoopVoice(nullptr), PoolSize(4), SustainedFireWindow(0.2f), LoopFadeOutTime(0.05f),
+	LastShotTime(-1.0), bLooping(false), bLoopIs2D(false)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UShooterWeaponAudioComponent::SetSounds(USoundBase* InShotSound, USoundBase* InLoopSound, USoundBase* InTailSound)
+{
+	EndLoop();
+	ShotSound = InShotSound;
+	LoopSound = InLoopSound;
+	TailSound = InTailSound;
+}
+
+void UShooterWeaponAudioComponent::PlayShots(int32 NumShots, bool bIs2D)
+{
+	if (NumShots <= 0 || GetNetMode() == NM_DedicatedServer)
+		return;
+
+	// Several shots in one frame or a shot right after the last one means the trigger is held
+	const double Now = GetWorld()->GetTimeSeconds();
+	const bool bSustained = LoopSound && (NumShots > 1 || Now - LastShotTime <= SustainedFireWindow);
+	LastShotTime = Now;
+
+	if (bSustained)
+	{
+		if (!bLooping)
+			StartLoop(bIs2D);
+
+		// The loop covers every shot until fire pauses for longer than the window
+		if (bLooping)
+		{
+			GetWorld()->GetTimerManager().SetTimer(LoopTimeoutHandle, this, &UShooterWeaponAudioComponent::EndLoop, SustainedFireWindow);
+			return;
+		}
+	}
+
+	if (!ShotSound)
+		return;
+
+	if (UAudioComponent* Voice = AcquireVoice(bIs2D))
+		PlayOnVoice(Voice, ShotSound, bIs2D);
+}
+
+void UShooterWeaponAudioComponent::StopSustainedFire()
+{
+	EndLoop();
+}
+
+void UShooterWeaponAudioComponent::OnUnregister()
+{
+	if (UWorld* World = GetWorld())
+		World->GetTimerManager().ClearTimer(LoopTimeoutHandle);
+	bLooping = false;
+
+	// Finish callbacks of destroyed voices never arrive, give their slots back now
+	if (UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio())
+		WeaponAudio->OnVoicesFinished(PlayingVoices.Num());
+	PlayingVoices.Empty();
+
+	Super::OnUnregister();
+}
+
+UShooterWeaponAudioSubsystem* UShooterWeaponAudioComponent::GetWeaponAudio() const
+{
+	UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UShooterWeaponAudioSubsystem>() : nullptr;
+}
+
+UAudioComponent* UShooterWeaponAudioComponent::AcquireVoice(bool bIs2D)
+{
+	UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio();
+	if (!WeaponAudio)
+		return nullptr;
+
+	if (WeaponAudio->CanStartVoice(bIs2D))
+	{
+		for (UAudioComponent* Voice : Voices)
+		{
+			if (!PlayingVoices.Contains(Voice))
+				return Voice;
+		}
+
+		if (Voices.Num() < PoolSize)
+		{
+			if (UAudioComponent* Voice = CreateVoice())
+			{
+				Voices.Add(Voice);
+				return Voice;
+			}
+		}
+	}
+
+	// Every voice is busy, restart the one whose sound started first, which keeps the voice count as it is
+	if (Voices.Num() > 0 && PlayingVoices.Num() == Voices.Num())
+	{
+		WeaponAudio->OnVoiceStolen();
+		return Voices[0];
+	}
+
+	WeaponAudio->OnShotDropped();
+	return nullptr;
+}
+
+UAudioComponent* UShooterWeaponAudioComponent::CreateVoice()
+{
+	AActor* Owner = GetOwner();
+	if (!Owner)
+		return nullptr;
+
+	UAudioComponent* Voice = NewObject<UAudioComponent>(Owner);
+	Voice->bAutoActivate = false;
+	Voice->bAutoDestroy = false;
+	Voice->bStopWhenOwnerDestroyed = true;
+	Voice->SetupAttachment(this);
+	Voice->RegisterComponent();
+	Voice->OnAudioFinishedNative.AddUObject(this, &UShooterWeaponAudioComponent::OnVoiceFinished);
+
+	if (UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio())
+		WeaponAudio->OnVoiceCreated();
+	return Voice;
+}
+
+void UShooterWeaponAudioComponent::PlayOnVoice(UAudioComponent* Voice, USoundBase* Sound, bool bIs2D)
+{
+	Voice->SetSound(Sound);
+	Voice->bAllowSpatialization = !bIs2D;
+	Voice->Play();
+
+	// Move to the back, the front is the voice to steal next
+	if (Voices.RemoveSingle(Voice) > 0)
+		Voices.Add(Voice);
+
+	INC_DWORD_STAT(STAT_WeaponSoundsPlayed);
+
+	UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio();
+	if (!WeaponAudio)
+		return;
+
+	// A restarted voice stays counted, it only reports finishing once its last sound ends
+	bool bAlreadyPlaying = false;
+	PlayingVoices.Add(Voice, &bAlreadyPlaying);
+	WeaponAudio->OnSoundPlayed(!bAlreadyPlaying);
+}
+
+void UShooterWeaponAudioComponent::StartLoop(bool bIs2D)
+{
+	UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio();
+	if (!WeaponAudio)
+		return;
+
+	// The loop voice is kept out of Voices, it is never handed out for shots
+	if (!LoopVoice)
+	{
+		if (!WeaponAudio->CanStartVoice(bIs2D))
+			return;
+
+		LoopVoice = CreateVoice();
+		if (!LoopVoice)
+			return;
+	}
+	else if (!PlayingVoices.Contains(LoopVoice) && !WeaponAudio->CanStartVoice(bIs2D))
+	{
+		return;
+	}
+
+	bLooping = true;
+	bLoopIs2D = bIs2D;
+	PlayOnVoice(LoopVoice, LoopSound, bIs2D);
+}
+
+void UShooterWeaponAudioComponent::EndLoop()
+{
+	if (UWorld* World = GetWorld())
+		World->GetTimerManager().ClearTimer(LoopTimeoutHandle);
+
+	if (!bLooping)
+		return;
+
+	bLooping = false;
+	LoopVoice->FadeOut(LoopFadeOutTime, 0.0f);
+
+	if (!TailSound)
+		return;
+
+	if (UAudioComponent* Voice = AcquireVoice(bLoopIs2D))
+		PlayOnVoice(Voice, TailSound, bLoopIs2D);
+}
+
+void UShooterWeaponAudioComponent::OnVoiceFinished(UAudioComponent* Voice)
+{
+	if (PlayingVoices.Remove(Voice) == 0)
+		return;
+
+	if (UShooterWeaponAudioSubsystem* WeaponAudio = GetWeaponAudio())
+		WeaponAudio->OnVoicesFinished(1);
+}
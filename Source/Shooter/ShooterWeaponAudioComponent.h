@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "ShooterWeaponAudioComponent.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+class UShooterWeaponAudioSubsystem;
+
+/**
+ * Plays weapon fire through a few recycled audio components instead of a new sound per shot.
+ * Shots closer together than SustainedFireWindow switch to a looping sound which ends with a
+ * tail once fire stops, and every component of a world shares one cap on playing weapon voices
+ */
+UCLASS(ClassGroup = (Audio), meta = (BlueprintSpawnableComponent))
+class SHOOTER_API UShooterWeaponAudioComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterWeaponAudioComponent();
+
+	// Sounds to play, a null loop keeps playing ShotSound for every shot
+	void SetSounds(USoundBase* InShotSound, USoundBase* InLoopSound, USoundBase* InTailSound);
+
+	// Plays NumShots fired this frame, non spatialized for the local player's own weapon
+	void PlayShots(int32 NumShots, bool bIs2D);
+
+	// Ends a running loop with its tail right away, called when the trigger is released
+	void StopSustainedFire();
+
+	FORCEINLINE bool IsLooping() const { return bLooping; }
+
+protected:
+	virtual void OnUnregister() override;
+
+private:
+	UShooterWeaponAudioSubsystem* GetWeaponAudio() const;
+
+	// Returns a voice for a one shot sound, null when the cap drops it
+	UAudioComponent* AcquireVoice(bool bIs2D);
+
+	UAudioComponent* CreateVoice();
+
+	void PlayOnVoice(UAudioComponent* Voice, USoundBase* Sound, bool bIs2D);
+
+	void StartLoop(bool bIs2D);
+
+	// Fades the loop out and plays the tail
+	void EndLoop();
+
+	void OnVoiceFinished(UAudioComponent* Voice);
+
+	// Single shot sound, also the first shot of a burst
+	UPROPERTY(Transient)
+	USoundBase* ShotSound;
+
+	// Looping sound covering sustained fire
+	UPROPERTY(Transient)
+	USoundBase* LoopSound;
+
+	// Played once a loop ends
+	UPROPERTY(Transient)
+	USoundBase* TailSound;
+
+	// Voices for shots and tails, created on demand up to PoolSize. Kept in the order their sounds started, oldest first
+	UPROPERTY(Transient)
+	TArray<UAudioComponent*> Voices;
+
+	// Voice reserved for the loop
+	UPROPERTY(Transient)
+	UAudioComponent* LoopVoice;
+
+	// Maximum number of shot and tail voices of this component
+	UPROPERTY(EditDefaultsOnly, Category = "Audio")
+	int32 PoolSize;
+
+	// Shots at most this many seconds apart count as sustained fire, also how long a loop outlives the last shot
+	UPROPERTY(EditDefaultsOnly, Category = "Audio")
+	float SustainedFireWindow;
+
+	// Fade applied when the loop stops
+	UPROPERTY(EditDefaultsOnly, Category = "Audio")
+	float LoopFadeOutTime;
+
+	// Voices of this component counted by the subsystem, from their start until they report finishing
+	TSet<UAudioComponent*> PlayingVoices;
+
+	double LastShotTime;
+	bool bLooping;
+	bool bLoopIs2D;
+	FTimerHandle LoopTimeoutHandle;
+};
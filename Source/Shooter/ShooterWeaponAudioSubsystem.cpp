@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterWeaponAudioSubsystem.h"
+#include "Shooter.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<int32> CVarMaxWeaponVoices(
+	TEXT("Shooter.Audio.MaxWeaponVoices"),
+	24,
+	TEXT("Maximum number of weapon voices playing at once across all characters. The local player's own weapon is never dropped"));
+
+bool UShooterWeaponAudioSubsystem::CanStartVoice(bool bIs2D) const
+{
+	return bIs2D || NumActiveVoices < GetMaxVoices();
+}
+
+void UShooterWeaponAudioSubsystem::OnSoundPlayed(bool bNewVoice)
+{
+	Stats.Plays++;
+	if (!bNewVoice)
+		return;
+
+	NumActiveVoices++;
+	Stats.PeakVoices = FMath::Max(Stats.PeakVoices, NumActiveVoices);
+}
+
+void UShooterWeaponAudioSubsystem::OnVoicesFinished(int32 NumVoices)
+{
+	NumActiveVoices = FMath::Max(NumActiveVoices - NumVoices, 0);
+}
+
+int32 UShooterWeaponAudioSubsystem::GetMaxVoices() const
+{
+	return CVarMaxWeaponVoices.GetValueOnGameThread();
+}
+
+void UShooterWeaponAudioSubsystem::ResetStats()
+{
+	Stats = FWeaponAudioStats();
+	Stats.PeakVoices = NumActiveVoices;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GWeaponAudioStatsCommand(
+	TEXT("Shooter.Audio.WeaponStats"),
+	TEXT("Prints weapon voices playing now and the weapon audio counters since the last reset. Args: [reset]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterWeaponAudioSubsystem* WeaponAudio = World ? World->GetSubsystem<UShooterWeaponAudioSubsystem>() : nullptr;
+		if (!WeaponAudio)
+			return;
+
+		const FWeaponAudioStats& Stats = WeaponAudio->GetStats();
+		UE_LOG(LogShooter, Display, TEXT("Weapon Audio: %d voices playing, %d peak, %d plays, %d voices created, %d steals, %d dropped"),
+			WeaponAudio->GetNumActiveVoices(), Stats.PeakVoices, Stats.Plays, Stats.VoicesCreated, Stats.Steals, Stats.Dropped);
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+			WeaponAudio->ResetStats();
+	}));
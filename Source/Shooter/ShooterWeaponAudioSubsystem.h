@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterWeaponAudioSubsystem.generated.h"
+
+// Weapon audio counters of a world, accumulated since the last reset
+struct FWeaponAudioStats
+{
+	// Shot, loop and tail sounds started
+	int32 Plays = 0;
+
+	// Audio components created for the pools
+	int32 VoicesCreated = 0;
+
+	// A still playing pooled voice was restarted for a new sound
+	int32 Steals = 0;
+
+	// Shots skipped because the weapon voice cap was reached
+	int32 Dropped = 0;
+
+	// Most weapon voices playing at once
+	int32 PeakVoices = 0;
+};
+
+/**
+ * Counts the weapon voices playing in a world, so every UShooterWeaponAudioComponent of the world
+ * shares one cap, and keeps the weapon audio counters. Each world, like each PIE instance, has its own
+ */
+UCLASS()
+class SHOOTER_API UShooterWeaponAudioSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// True when a new voice may start without going over the cap, the local player's own weapon always may
+	bool CanStartVoice(bool bIs2D) const;
+
+	// A component started a sound, bNewVoice when the voice wasn't playing before
+	void OnSoundPlayed(bool bNewVoice);
+
+	void OnVoicesFinished(int32 NumVoices);
+
+	// Counters only
+	void OnVoiceCreated() { Stats.VoicesCreated++; }
+	void OnVoiceStolen() { Stats.Steals++; }
+	void OnShotDropped() { Stats.Dropped++; }
+
+	FORCEINLINE int32 GetNumActiveVoices() const { return NumActiveVoices; }
+	int32 GetMaxVoices() const;
+
+	FORCEINLINE const FWeaponAudioStats& GetStats() const { return Stats; }
+	void ResetStats();
+
+private:
+	// Playing weapon voices across all components of the world
+	int32 NumActiveVoices = 0;
+
+	FWeaponAudioStats Stats;
+};
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ShooterWeaponAudioComponent.h"
+#include "ShooterWeaponAudioSubsystem.h"
+#include "FireScheduler.h"
+#include "ShooterTestWorld.h"
+#include "Sound/SoundWave.h"
+
+namespace
+{
+	constexpr int32 WeaponAudioTestPlayers = 32;
+	constexpr float WeaponAudioTestSeconds = 60.0f;
+	constexpr float WeaponAudioTestFrameTime = 1.0f / 60.0f;
+
+	// Shot voices of a component with the default pool size
+	constexpr int32 WeaponAudioTestPoolSize = 4;
+
+	// Bursts of this many seconds with the trigger held, then a pause, so loops end with their tails
+	constexpr float WeaponAudioTestBurst = 3.0f;
+	constexpr float WeaponAudioTestPause = 0.5f;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWeaponAudioFullAutoTest, "Shooter.Audio.FullAuto", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FWeaponAudioFullAutoTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UShooterWeaponAudioSubsystem* WeaponAudio = World->GetSubsystem<UShooterWeaponAudioSubsystem>();
+	if (!TestNotNull(TEXT("Weapon audio subsystem"), WeaponAudio))
+		return false;
+
+	USoundWave* ShotSound = NewObject<USoundWave>();
+	USoundWave* LoopSound = NewObject<USoundWave>();
+	USoundWave* TailSound = NewObject<USoundWave>();
+
+	// Nobody is the local player here, every voice counts against the cap
+	TArray<UShooterWeaponAudioComponent*> Components;
+	TArray<FFireScheduler> Schedulers;
+	for (int32 Player = 0; Player < WeaponAudioTestPlayers; Player++)
+	{
+		AActor* Owner = World->SpawnActor<AActor>();
+		UShooterWeaponAudioComponent* Component = NewObject<UShooterWeaponAudioComponent>(Owner);
+		Owner->SetRootComponent(Component);
+		Component->RegisterComponent();
+		Component->SetSounds(ShotSound, LoopSound, TailSound);
+		Components.Add(Component);
+		Schedulers.Emplace(0.1f);
+	}
+
+	// Headless there is no audio device, voices never report finishing and stay busy the whole time,
+	// the worst case for the cap and the steals
+	WeaponAudio->ResetStats();
+	TArray<double> ShotTimes;
+	const int32 NumFrames = FMath::RoundToInt(WeaponAudioTestSeconds / WeaponAudioTestFrameTime);
+	for (int32 Frame = 1; Frame <= NumFrames; Frame++)
+	{
+		TestWorld.Tick(WeaponAudioTestFrameTime);
+		const double Now = World->GetTimeSeconds();
+
+		for (int32 Player = 0; Player < WeaponAudioTestPlayers; Player++)
+		{
+			// Players start their bursts at different times
+			const float Cycle = FMath::Fmod(static_cast<float>(Now) + Player * 0.1f, WeaponAudioTestBurst + WeaponAudioTestPause);
+			FFireScheduler& Scheduler = Schedulers[Player];
+			int32 NumShots = 0;
+			if (Cycle < WeaponAudioTestBurst)
+			{
+				ShotTimes.Reset();
+				if (Scheduler.IsTriggerHeld())
+					NumShots = Scheduler.Advance(Now, ShotTimes);
+				else if (Scheduler.PressTrigger(Now))
+					NumShots = 1;
+			}
+			else if (Scheduler.IsTriggerHeld())
+			{
+				Scheduler.ReleaseTrigger();
+				Components[Player]->StopSustainedFire();
+			}
+
+			if (NumShots > 0)
+				Components[Player]->PlayShots(NumShots, false);
+		}
+	}
+
+	const FWeaponAudioStats& Stats = WeaponAudio->GetStats();
+	AddInfo(FString::Printf(TEXT("%d players, %.0f s of full auto: %d voices playing at the end, %d peak, %d plays, %d voices created, %d steals, %d dropped"),
+		WeaponAudioTestPlayers, WeaponAudioTestSeconds, WeaponAudio->GetNumActiveVoices(), Stats.PeakVoices, Stats.Plays, Stats.VoicesCreated, Stats.Steals, Stats.Dropped));
+
+	TestTrue(TEXT("Playing voices stay within the cap"), Stats.PeakVoices <= WeaponAudio->GetMaxVoices());
+	TestTrue(TEXT("Voices are only created to fill the pools"), Stats.VoicesCreated <= WeaponAudio->GetMaxVoices());
+	TestTrue(TEXT("Shots over the cap were stolen or dropped"), Stats.Steals > 0 && Stats.Dropped > 0);
+	TestTrue(TEXT("Weapons were heard"), Stats.Plays > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWeaponAudioVoiceCapTest, "Shooter.Audio.VoiceCap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FWeaponAudioVoiceCapTest::RunTest(const FString& Parameters)
+{
+	FShooterTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UShooterWeaponAudioSubsystem* WeaponAudio = World->GetSubsystem<UShooterWeaponAudioSubsystem>();
+	if (!TestNotNull(TEXT("Weapon audio subsystem"), WeaponAudio))
+		return false;
+
+	const int32 MaxVoices = WeaponAudio->GetMaxVoices();
+	if (!TestTrue(TEXT("More players than voices"), MaxVoices > 0 && MaxVoices < WeaponAudioTestPlayers))
+		return false;
+
+	// Without a loop sound every shot needs a voice of its own
+	USoundWave* ShotSound = NewObject<USoundWave>();
+
+	// Player 0 is the local player, its weapon plays in 2D
+	TArray<UShooterWeaponAudioComponent*> Components;
+	for (int32 Player = 0; Player <= WeaponAudioTestPlayers; Player++)
+	{
+		AActor* Owner = World->SpawnActor<AActor>();
+		UShooterWeaponAudioComponent* Component = NewObject<UShooterWeaponAudioComponent>(Owner);
+		Owner->SetRootComponent(Component);
+		Component->RegisterComponent();
+		Component->SetSounds(ShotSound, nullptr, nullptr);
+		Components.Add(Component);
+	}
+
+	// One shot per player and frame, and headless no voice ever finishes
+	constexpr int32 NumFrames = 10;
+	WeaponAudio->ResetStats();
+	int32 PeakOtherVoices = 0;
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		TestWorld.Tick(WeaponAudioTestFrameTime);
+		for (int32 Player = 0; Player <= WeaponAudioTestPlayers; Player++)
+			Components[Player]->PlayShots(1, Player == 0);
+
+		const int32 LocalVoices = FMath::Min(Frame + 1, WeaponAudioTestPoolSize);
+		PeakOtherVoices = FMath::Max(PeakOtherVoices, WeaponAudio->GetNumActiveVoices() - LocalVoices);
+	}
+
+	// The first frame hands a voice to the local player and to the players ahead in line until the cap is reached, those
+	// keep stealing their voice from then on and everyone else drops every shot. The local player fills its pool over the cap
+	const int32 OtherPlayersWithVoice = MaxVoices - 1;
+	const FWeaponAudioStats& Stats = WeaponAudio->GetStats();
+	TestTrue(TEXT("Other players' voices stay within the cap"), PeakOtherVoices <= MaxVoices);
+	TestEqual(TEXT("Peak voices"), Stats.PeakVoices, OtherPlayersWithVoice + WeaponAudioTestPoolSize);
+	TestEqual(TEXT("Voices created"), Stats.VoicesCreated, OtherPlayersWithVoice + WeaponAudioTestPoolSize);
+	TestEqual(TEXT("Dropped"), Stats.Dropped, (WeaponAudioTestPlayers - OtherPlayersWithVoice) * NumFrames);
+	TestEqual(TEXT("Steals"), Stats.Steals, OtherPlayersWithVoice * (NumFrames - 1) + (NumFrames - WeaponAudioTestPoolSize));
+	TestEqual(TEXT("Plays"), Stats.Plays, (1 + WeaponAudioTestPlayers) * NumFrames - Stats.Dropped);
+	return true;
+}
+
+#endif
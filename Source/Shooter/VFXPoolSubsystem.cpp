@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VFXPoolSubsystem.h"
+#include "Shooter.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Emitters Spawned"), STAT_EmittersSpawned, STATGROUP_Shooter);
+
+void UVFXPoolSubsystem::Deinitialize()
+{
+	for (auto& Pair : Pools)
+	{
+		for (UParticleSystemComponent* PSC : Pair.Value.Free)
+		{
+			if (PSC)
+				PSC->DestroyComponent();
+		}
+
+		for (UParticleSystemComponent* PSC : Pair.Value.Active)
+		{
+			if (PSC)
+				PSC->DestroyComponent();
+		}
+	}
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UVFXPoolSubsystem::PrewarmTemplate(UParticleSystem* Template, int32 Budget)
+{
+	if (!Template || Budget <= 0)
+		return;
+
+	FVFXPoolEntry& Entry = Pools.FindOrAdd(Template);
+	Entry.Budget = FMath::Max(Entry.Budget, Budget);
+
+	while (Entry.Free.Num() + Entry.Active.Num() < Entry.Budget)
+	{
+		UParticleSystemComponent* PSC = CreateComponent(Template);
+		if (!PSC)
+			break;
+
+		Entry.Free.Add(PSC);
+	}
+}
+
+UParticleSystemComponent* UVFXPoolSubsystem::SpawnEmitter(UParticleSystem* Template, const FTransform& Transform)
+{
+	if (!Template)
+		return nullptr;
+
+	FVFXPoolEntry& Entry = Pools.FindOrAdd(Template);
+	if (Entry.Budget <= 0)
+		Entry.Budget = DefaultBudget;
+
+	UParticleSystemComponent* PSC = nullptr;
+	if (Entry.Free.Num() > 0)
+	{
+		PSC = Entry.Free.Pop(false);
+		Stats.Hits++;
+	}
+	else if (Entry.Active.Num() < Entry.Budget)
+	{
+		PSC = CreateComponent(Template);
+		Stats.Misses++;
+	}
+	else
+	{
+		// Out of budget, recycle the component which has been playing the longest
+		PSC = Entry.Active[0];
+		Entry.Active.RemoveAt(0, 1, false);
+		PSC->KillParticlesForced();
+		Stats.Steals++;
+	}
+
+	if (!PSC)
+		return nullptr;
+
+	PSC->SetWorldTransform(Transform);
+	PSC->Activate(true);
+	INC_DWORD_STAT(STAT_EmittersSpawned);
+	Entry.Active.Add(PSC);
+
+	return PSC;
+}
+
+UParticleSystemComponent* UVFXPoolSubsystem::SpawnEmitter(UParticleSystem* Template, const FVector& Location)
+{
+	return SpawnEmitter(Template, FTransform(Location));
+}
+
+UParticleSystemComponent* UVFXPoolSubsystem::CreateComponent(UParticleSystem* Template)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+		return nullptr;
+
+	// Same outer UGameplayStatics uses for unattached emitters
+	UObject* Outer = World->GetWorldSettings() ? static_cast<UObject*>(World->GetWorldSettings()) : static_cast<UObject*>(World);
+	UParticleSystemComponent* PSC = NewObject<UParticleSystemComponent>(Outer);
+	PSC->bAutoDestroy = false;
+	PSC->bAutoActivate = false;
+	PSC->bAllowAnyoneToDestroyMe = true;
+	PSC->SetTemplate(Template);
+	PSC->OnSystemFinished.AddDynamic(this, &UVFXPoolSubsystem::OnEmitterFinished);
+	PSC->RegisterComponentWithWorld(World);
+
+	return PSC;
+}
+
+void UVFXPoolSubsystem::OnEmitterFinished(UParticleSystemComponent* PSystem)
+{
+	if (!PSystem)
+		return;
+
+	FVFXPoolEntry* Entry = Pools.Find(PSystem->Template);
+	if (!Entry)
+		return;
+
+	// Stolen components are no longer in the active list and must not be freed twice
+	if (Entry->Active.RemoveSingle(PSystem) > 0)
+		Entry->Free.Add(PSystem);
+}
+
+static FAutoConsoleCommandWithWorld GVFXPoolStatsCommand(
+	TEXT("Shooter.VFXPool.Stats"),
+	TEXT("Prints weapon VFX pool hits, misses and steals"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UVFXPoolSubsystem* VFXPool = World ? World->GetSubsystem<UVFXPoolSubsystem>() : nullptr)
+		{
+			const FVFXPoolStats& Stats = VFXPool->GetStats();
+			UE_LOG(LogShooter, Display, TEXT("VFX Pool: %d hits, %d misses, %d steals"), Stats.Hits, Stats.Misses, Stats.Steals);
+		}
+	}));
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VFXPoolSubsystem.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+
+// Pool counters, accumulated since the last reset
+struct FVFXPoolStats
+{
+	// Served from a free pooled component
+	int32 Hits = 0;
+
+	// No free component, a new one had to be created
+	int32 Misses = 0;
+
+	// Budget reached, the oldest active component was recycled
+	int32 Steals = 0;
+};
+
+USTRUCT()
+struct FVFXPoolEntry
+{
+	GENERATED_BODY()
+
+	// Components ready to be handed out
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> Free;
+
+	// Components currently playing, oldest first
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> Active;
+
+	// Maximum number of components alive for this template
+	int32 Budget = 0;
+};
+
+/**
+ * Hands out recycled particle system components so that weapon effects don't
+ * create and destroy a component for every shot
+ */
+UCLASS()
+class SHOOTER_API UVFXPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Creates components for Template up to Budget and uses Budget as its cap
+	void PrewarmTemplate(UParticleSystem* Template, int32 Budget);
+
+	// Activates a pooled component of Template at Transform
+	UParticleSystemComponent* SpawnEmitter(UParticleSystem* Template, const FTransform& Transform);
+
+	UParticleSystemComponent* SpawnEmitter(UParticleSystem* Template, const FVector& Location);
+
+	FORCEINLINE const FVFXPoolStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = FVFXPoolStats(); }
+
+private:
+	UParticleSystemComponent* CreateComponent(UParticleSystem* Template);
+
+	// Returns a finished component to the free list
+	UFUNCTION()
+	void OnEmitterFinished(UParticleSystemComponent* PSystem);
+
+	// Cap used for templates which were never prewarmed
+	int32 DefaultBudget = 16;
+
+	UPROPERTY()
+	TMap<UParticleSystem*, FVFXPoolEntry> Pools;
+
+	FVFXPoolStats Stats;
+};
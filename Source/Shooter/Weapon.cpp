@@ -1,11 +1,17 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Weapon.h"
+#include "Shooter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Falling Weapons"), STAT_FallingWeapons, STATGROUP_Shooter);
 
 AWeapon::AWeapon()
-	: ThrowWeaponTime(0.7f), bFalling(false)
+	: ThrowWeaponTime(0.7f), bFalling(false),
+	FireMode(EWeaponFireMode::EWFM_Hitscan), ProjectileSpeed(5000.0f), ProjectileGravityScale(0.0f), ProjectileRadius(0.0f), ProjectileLifeTime(5.0f)
 {
+	// Only ticks while falling to keep the weapon upright
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 void AWeapon::Tick(float DeltaTime)
@@ -15,6 +21,7 @@ void AWeapon::Tick(float DeltaTime)
 	// Keep the Weapon upright
 	if (GetItemState() == EItemState::EIS_Falling && bFalling)
 	{
+		INC_DWORD_STAT(STAT_FallingWeapons);
 		const FRotator MeshRotation{ 0.f, GetItemMesh()->GetComponentRotation().Yaw, 0.f };
 		GetItemMesh()->SetWorldRotation(MeshRotation, false, nullptr, ETeleportType::TeleportPhysics);
 	}
@@ -35,11 +42,33 @@ void AWeapon::ThrowWeapon()
 	GetItemMesh()->AddImpulse(ImpulseDirection);
 
 	bFalling = true;
+	SetActorTickEnabled(true);
 	GetWorldTimerManager().SetTimer(ThrowWeaponHandler, this, &AWeapon::StopFalling, ThrowWeaponTime);
 }
 
 void AWeapon::StopFalling()
 {
 	bFalling = false;
+	SetActorTickEnabled(false);
 	SetItemState(EItemState::EIS_Pickup);
 }
+
+void AWeapon::OnReleasedToPool()
+{
+	// A weapon released mid throw must not finish falling while parked
+	GetWorldTimerManager().ClearTimer(ThrowWeaponHandler);
+	bFalling = false;
+	SetActorTickEnabled(false);
+
+	Super::OnReleasedToPool();
+}
+
+FProjectileParams AWeapon::GetProjectileParams(UParticleSystem* ImpactParticles) const
+{
+	FProjectileParams Params;
+	Params.Radius = ProjectileRadius;
+	Params.GravityScale = ProjectileGravityScale;
+	Params.LifeTime = ProjectileLifeTime;
+	Params.ImpactParticles = ImpactParticles;
+	return Params;
+}
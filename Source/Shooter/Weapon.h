@@ -4,8 +4,18 @@
 
 #include "CoreMinimal.h"
 #include "Item.h"
+#include "ProjectileSubsystem.h"
 #include "Weapon.generated.h"
 
+UENUM(BlueprintType)
+enum class EWeaponFireMode : uint8
+{
+	EWFM_Hitscan UMETA(DisplayName = "Hitscan"),
+	EWFM_Projectile UMETA(DisplayName = "Projectile"),
+
+	EWFM_MAX UMETA(DisplayName = "DefaultMax")
+};
+
 /**
  * 
  */
@@ -26,7 +36,35 @@ private:
 	float ThrowWeaponTime;
 	bool bFalling;
 
+	// Hitscan weapons hit instantly, projectile weapons launch into UProjectileSubsystem
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	EWeaponFireMode FireMode;
+
+	// Launch speed of projectiles
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", EditCondition = "FireMode == EWeaponFireMode::EWFM_Projectile"))
+	float ProjectileSpeed;
+
+	// Multiplier on world gravity, grenades arc while bolts fly straight
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", EditCondition = "FireMode == EWeaponFireMode::EWFM_Projectile"))
+	float ProjectileGravityScale;
+
+	// Sweep radius of projectiles
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", EditCondition = "FireMode == EWeaponFireMode::EWFM_Projectile"))
+	float ProjectileRadius;
+
+	// Seconds before a projectile which hit nothing expires
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", EditCondition = "FireMode == EWeaponFireMode::EWFM_Projectile"))
+	float ProjectileLifeTime;
+
 public:
 	// Adds an impulse to the weapon
 	void ThrowWeapon();
+
+	virtual void OnReleasedToPool() override;
+
+	FORCEINLINE EWeaponFireMode GetFireMode() const { return FireMode; }
+	FORCEINLINE float GetProjectileSpeed() const { return ProjectileSpeed; }
+
+	// Flight parameters of this weapon's projectiles
+	FProjectileParams GetProjectileParams(UParticleSystem* ImpactParticles) const;
 };
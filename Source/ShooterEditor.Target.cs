@@ -10,5 +10,8 @@ public class ShooterEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		ExtraModuleNames.AddRange( new string[] { "Shooter" } );
+
+		// Item and character replication marks properties dirty instead of comparing them every net update
+		bWithPushModel = true;
 	}
 }